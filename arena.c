@@ -0,0 +1,81 @@
+#include "mat_utils.h"
+#include "arena.h"
+
+#define ARENA_MIN_BLOCK (64 * 1024)
+
+static size_t align_up(size_t size){
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+size_t arena_matrix_bytes(const int rows, const int cols){
+    return align_up(rows * sizeof(double *)) + align_up((size_t)rows * cols * sizeof(double));
+}
+
+void arena_init(arena *a, size_t block_size){
+    a->head = NULL;
+    a->block_size = block_size < ARENA_MIN_BLOCK ? ARENA_MIN_BLOCK : block_size;
+}
+
+/**
+ * @brief Push a new block able to hold at least size bytes.
+ *
+ * @return The new block, NULL if the allocation failed.
+ */
+static arena_block *arena_grow(arena *a, size_t size){
+    arena_block *block;
+    size_t capacity = size > a->block_size ? size : a->block_size;
+    size_t offset;
+
+    block = (arena_block *)malloc(sizeof(arena_block) + capacity + ARENA_ALIGNMENT);
+    if (block == NULL) {
+        return NULL;
+    }
+    matrix_add_allocations(1);
+
+    /* skip the header and round the first byte up to the alignment */
+    offset = ARENA_ALIGNMENT - (size_t)(block + 1) % ARENA_ALIGNMENT;
+    block->base = (char *)(block + 1) + offset;
+    block->capacity = capacity;
+    block->used = 0;
+    block->next = a->head;
+    a->head = block;
+    return block;
+}
+
+void *arena_alloc(arena *a, size_t size){
+    arena_block *block = a->head;
+    void *ptr;
+
+    size = align_up(size);
+    if (block == NULL || block->used + size > block->capacity) {
+        block = arena_grow(a, size);
+        if (block == NULL) {
+            return NULL;
+        }
+    }
+    ptr = block->base + block->used;
+    block->used += size;
+    return ptr;
+}
+
+double **arena_matrix(arena *a, const int rows, const int cols){
+    int i;
+    double **mat = (double **)arena_alloc(a, rows * sizeof(double *));
+    double *data = (double *)arena_alloc(a, (size_t)rows * cols * sizeof(double));
+    if (mat == NULL || data == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < rows; i++) {
+        mat[i] = data + (size_t)i * cols;
+    }
+    return mat;
+}
+
+void arena_release(arena *a){
+    arena_block *next;
+    while (a->head != NULL) {
+        next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+}
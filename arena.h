@@ -0,0 +1,71 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+/* Every allocation starts on a cache line boundary. */
+#define ARENA_ALIGNMENT 64
+
+typedef struct arena_block {
+    struct arena_block *next;
+    char *base;
+    size_t capacity;
+    size_t used;
+} arena_block;
+
+/**
+ * @brief Bump allocator owning all scratch memory of one invocation.
+ *
+ * Allocations are carved out of large blocks and are only given back, all
+ * at once, by arena_release.
+ */
+typedef struct {
+    arena_block *head;
+    size_t block_size;
+} arena;
+
+/**
+ * @brief Number of bytes arena_matrix needs for a rows x cols matrix.
+ *
+ * Summing this over all scratch matrices gives a block_size that serves
+ * them all from a single block.
+ */
+size_t arena_matrix_bytes(const int rows, const int cols);
+
+/**
+ * @brief Initialize an empty arena.
+ *
+ * @param a Arena to initialize.
+ * @param block_size Preferred size of each block; larger requests get their own block.
+ */
+void arena_init(arena *a, size_t block_size);
+
+/**
+ * @brief Allocate size bytes aligned to ARENA_ALIGNMENT.
+ *
+ * @param a Arena to allocate from.
+ * @param size Number of bytes.
+ * @return Pointer to the memory, NULL if a new block could not be allocated.
+ */
+void *arena_alloc(arena *a, size_t size);
+
+/**
+ * @brief Allocate a rows x cols matrix with contiguous rows.
+ *
+ * The matrix must not be passed to free_matrix; it lives until arena_release.
+ *
+ * @param a Arena to allocate from.
+ * @param rows Number of rows in the matrix.
+ * @param cols Number of columns in the matrix.
+ * @return Allocated matrix, NULL on failure.
+ */
+double **arena_matrix(arena *a, const int rows, const int cols);
+
+/**
+ * @brief Free every block of the arena. The arena can be reused afterwards.
+ *
+ * @param a Arena to release.
+ */
+void arena_release(arena *a);
+
+#endif
@@ -0,0 +1,807 @@
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
+#include "symnmf.h"
+#include "perf_counters.h"
+
+#define MAX_GRID 16
+#define MAX_RESULTS 1024
+#define NAME_LEN 32
+#define PATH_LEN 256
+#define DEFAULT_WARMUP 1
+#define DEFAULT_REPS 5
+#define DEFAULT_THRESHOLD 0.10
+#define BENCH_SEED 1234
+/* Iterations of the eight multiply-add chains timed for the peak FLOP/s. */
+#define PEAK_ITERS (1L << 22)
+/* Length of each STREAM triad array, 32 MiB, well beyond the last level cache. */
+#define TRIAD_LEN (1L << 22)
+#define ROOFLINE_REPS 3
+
+enum OutputFormat{
+    FORMAT_JSON,
+    FORMAT_CSV
+};
+
+/**
+ * @brief Timing and throughput of one benchmarked kernel at one grid point.
+ *
+ * flops and bytes are the nominal work and the compulsory memory traffic
+ * (operands read once, result written once) of a single repetition.
+ * counters are the mean hardware counts of a repetition, -1 when not profiled.
+ */
+typedef struct {
+    char name[NAME_LEN];
+    int n, d, k;
+    int reps;
+    double best, mean;
+    double flops, bytes;
+    double baseline;
+    double counters[PERF_COUNTER_COUNT];
+} bench_result;
+
+typedef struct {
+    int ns[MAX_GRID], ds[MAX_GRID], ks[MAX_GRID];
+    int n_count, d_count, k_count;
+    int warmup, reps;
+    enum OutputFormat format;
+    const char *output;
+    const char *compare;
+    const char *data_dir;
+    double threshold;
+    int threads;
+    int tile;
+    int profile;
+} bench_config;
+
+/**
+ * @brief Inputs shared by the kernels of one grid point.
+ *
+ * H0 is a pristine copy of H, restored before every repetition so that
+ * kernels updating H in place always start from the same matrix.
+ */
+typedef struct {
+    double **X, **W, **H, **H0;
+    int n, d, k;
+    const char *path;
+} bench_input;
+
+/**
+ * @brief Peak multiply-add rate and STREAM triad bandwidth of this build on the bench threads.
+ */
+typedef struct {
+    double flops;
+    double bytes;
+} bench_roofline;
+
+typedef struct {
+    double *a, *b, *c;
+} triad_ctx;
+
+typedef void (*bench_kernel)(bench_input *in);
+typedef double **(*bench_goal)(double **X, const int n, const int d, symnmf_stats *stats);
+
+static bench_result results[MAX_RESULTS];
+static int results_count = 0;
+static perf_counters counters;
+static bench_roofline roofline;
+
+/* Accumulates a value from every kernel run so the work cannot be elided. */
+static volatile double bench_sink = 0.0;
+
+/**
+ * @brief Current value of the monotonic clock in seconds.
+ */
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Parse a comma separated list of positive integers.
+ *
+ * @param arg String such as "100,200,400".
+ * @param out Output array of at most MAX_GRID values.
+ * @return Number of values parsed, 0 on malformed input or more than MAX_GRID values.
+ */
+static int parse_int_list(const char *arg, int *out){
+    int count = 0;
+    char *end;
+    long value;
+
+    while (*arg != '\0') {
+        if (count == MAX_GRID) {
+            return 0;
+        }
+        value = strtol(arg, &end, 10);
+        if (end == arg || value <= 0) {
+            return 0;
+        }
+        out[count++] = (int)value;
+        arg = end;
+        if (*arg == DELIMITER) {
+            arg++;
+        } else if (*arg != '\0') {
+            return 0;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Fill a matrix with uniform values in [low, high).
+ */
+static void fill_uniform(double **mat, const int rows, const int cols, double low, double high){
+    int i, j;
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < cols; j++) {
+            mat[i][j] = low + (high - low) * ((double)rand() / ((double)RAND_MAX + 1.0));
+        }
+    }
+}
+
+/**
+ * @brief Write X to a file in the format expected by read_data.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int write_data(const char *path, double **X, const int n, const int d){
+    int i, j;
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < d; j++) {
+            fprintf(file, "%.4f%c", X[i][j], j < d - 1 ? DELIMITER : '\n');
+        }
+    }
+    return fclose(file) != 0;
+}
+
+static double file_size(const char *path){
+    long size;
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return 0.0;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+    return size < 0 ? 0.0 : (double)size;
+}
+
+static void consume(double **mat, const int rows, const int cols){
+    if (mat == NULL) {
+        printf("%s\n", ERROR_MESSAGE);
+        exit(1);
+    }
+    bench_sink += mat[rows - 1][cols - 1];
+}
+
+static void kernel_read_data(bench_input *in){
+    int n, d;
+    double **X = read_data(in->path, &n, &d);
+    consume(X, n, d);
+    free_matrix(X, n);
+}
+
+static void kernel_sym(bench_input *in){
+    double **A = sym(in->X, in->n, in->d, NULL);
+    consume(A, in->n, in->n);
+    free_matrix(A, in->n);
+}
+
+static void kernel_norm(bench_input *in){
+    double **W = norm(in->X, in->n, in->d, NULL);
+    consume(W, in->n, in->n);
+    free_matrix(W, in->n);
+}
+
+static void kernel_multiply(bench_input *in){
+    double **WH = multiply_matrixes(in->W, in->H, in->n, in->n, in->k);
+    consume(WH, in->n, in->k);
+    free_matrix(WH, in->n);
+}
+
+static void kernel_update_H(bench_input *in){
+    if (update_H(in->H, in->W, in->n, in->k, NULL) != 0) {
+        consume(NULL, 0, 0);
+    }
+    bench_sink += in->H[0][0];
+}
+
+static void goal_partial(bench_input *in, bench_goal goal){
+    int n, d;
+    double **X, **res;
+    X = read_data(in->path, &n, &d);
+    consume(X, n, d);
+    res = goal(X, n, d, NULL);
+    consume(res, n, n);
+    free_matrix(X, n);
+    free_matrix(res, n);
+}
+
+static void goal_sym(bench_input *in){
+    goal_partial(in, sym);
+}
+
+static void goal_ddg(bench_input *in){
+    goal_partial(in, ddg);
+}
+
+static void goal_norm(bench_input *in){
+    goal_partial(in, norm);
+}
+
+static void goal_symnmf(bench_input *in){
+    int n, d;
+    double **X, **W, **H;
+    X = read_data(in->path, &n, &d);
+    consume(X, n, d);
+    W = norm(X, n, d, NULL);
+    consume(W, n, n);
+    H = allocate_matrix(n, in->k);
+    consume(H, n, in->k);
+    srand(BENCH_SEED);
+    initialize_H(H, W, n, in->k);
+    consume(symnmf(H, W, n, in->k, NULL), n, in->k);
+    free_matrix(X, n);
+    free_matrix(W, n);
+    free_matrix(H, n);
+}
+
+/**
+ * @brief Put back the H every repetition starts from, if the grid point has one.
+ */
+static void restore_input(bench_input *in){
+    if (in->H0 != NULL) {
+        copy_matrix(in->H, in->H0, in->n, in->k);
+    }
+}
+
+/**
+ * @brief Time a kernel with warm-up and repetitions and record the result.
+ *
+ * @return 0 on success, 1 if the result table is full.
+ */
+static int run_kernel(const bench_config *cfg, const char *name, bench_kernel kernel, bench_input *in,
+                      const int k, double flops, double bytes){
+    int r, c;
+    double start, elapsed, total = 0.0, best = -1.0;
+    double counts[PERF_COUNTER_COUNT], sums[PERF_COUNTER_COUNT];
+    bench_result *res;
+
+    if (results_count >= MAX_RESULTS) {
+        return 1;
+    }
+    for (r = 0; r < cfg->warmup; r++) {
+        restore_input(in);
+        kernel(in);
+    }
+    for (c = 0; c < PERF_COUNTER_COUNT; c++) {
+        sums[c] = cfg->profile ? 0.0 : -1.0;
+    }
+    for (r = 0; r < cfg->reps; r++) {
+        restore_input(in);
+        /* the counters are switched outside the timed region */
+        if (cfg->profile) {
+            perf_counters_start(&counters);
+        }
+        start = now_seconds();
+        kernel(in);
+        elapsed = now_seconds() - start;
+        if (cfg->profile) {
+            perf_counters_stop(&counters, counts);
+            for (c = 0; c < PERF_COUNTER_COUNT; c++) {
+                sums[c] = sums[c] < 0.0 || counts[c] < 0.0 ? -1.0 : sums[c] + counts[c];
+            }
+        }
+        total += elapsed;
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    res = &results[results_count++];
+    strcpy(res->name, name);
+    res->n = in->n;
+    res->d = in->d;
+    res->k = k;
+    res->reps = cfg->reps;
+    res->best = best;
+    res->mean = total / cfg->reps;
+    res->flops = flops;
+    res->bytes = bytes;
+    res->baseline = -1.0;
+    for (c = 0; c < PERF_COUNTER_COUNT; c++) {
+        res->counters[c] = sums[c] < 0.0 ? -1.0 : sums[c] / cfg->reps;
+    }
+    fprintf(stderr, "%-16s n=%-6d d=%-4d k=%-4d best %.6fs\n", name, in->n, in->d, k, best);
+    return 0;
+}
+
+/**
+ * @brief Run every kernel and goal for one (n, d) point of the grid.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int run_point(const bench_config *cfg, const int n, const int d){
+    int i, status = 0;
+    double N = n, D = d, K, A, sym_flops, norm_flops;
+    char path[PATH_LEN];
+    bench_input in;
+
+    if (strlen(cfg->data_dir) + 64 > PATH_LEN) {
+        return 1;
+    }
+    sprintf(path, "%s/bench_data_%d_%d.txt", cfg->data_dir, n, d);
+
+    in.n = n;
+    in.d = d;
+    in.k = 0;
+    in.path = path;
+    in.H = NULL;
+    in.H0 = NULL;
+    in.X = allocate_matrix(n, d);
+    if (in.X == NULL) {
+        return 1;
+    }
+    srand(BENCH_SEED);
+    fill_uniform(in.X, n, d, -5.0, 5.0);
+    if (write_data(path, in.X, n, d) != 0) {
+        free_matrix(in.X, n);
+        return 1;
+    }
+    in.W = norm(in.X, n, d, NULL);
+    if (in.W == NULL) {
+        free_matrix(in.X, n);
+        remove(path);
+        return 1;
+    }
+
+    /* squared distance is 3d flops per pair, plus one for the exponential */
+    A = N * N * 8.0;
+    sym_flops = N * N * (3.0 * D + 1.0);
+    norm_flops = sym_flops + N * N + 4.0 * N * N * N;
+
+    status |= run_kernel(cfg, "read_data", kernel_read_data, &in, 0, 0.0, file_size(path) + N * D * 8.0);
+    status |= run_kernel(cfg, "sym", kernel_sym, &in, 0, sym_flops, N * D * 8.0 + A);
+    status |= run_kernel(cfg, "norm", kernel_norm, &in, 0, norm_flops, N * D * 8.0 + A);
+    status |= run_kernel(cfg, "goal_sym", goal_sym, &in, 0, sym_flops, file_size(path) + A);
+    status |= run_kernel(cfg, "goal_ddg", goal_ddg, &in, 0, sym_flops + N * N, file_size(path) + A);
+    status |= run_kernel(cfg, "goal_norm", goal_norm, &in, 0, norm_flops, file_size(path) + A);
+
+    for (i = 0; i < cfg->k_count && status == 0; i++) {
+        in.k = cfg->ks[i];
+        if (in.k >= n) {
+            continue;
+        }
+        K = in.k;
+        in.H = allocate_matrix(n, in.k);
+        in.H0 = allocate_matrix(n, in.k);
+        if (in.H == NULL || in.H0 == NULL) {
+            free_matrix(in.H, n);
+            free_matrix(in.H0, n);
+            status = 1;
+            break;
+        }
+        srand(BENCH_SEED);
+        initialize_H(in.H0, in.W, n, in.k);
+        status |= run_kernel(cfg, "multiply_matrixes", kernel_multiply, &in, in.k,
+                             2.0 * N * N * K, A + 2.0 * N * K * 8.0);
+        status |= run_kernel(cfg, "update_H", kernel_update_H, &in, in.k,
+                             6.0 * N * N * K + 4.0 * N * K, 3.0 * A + 6.0 * N * K * 8.0);
+        /* the iteration count is data dependent, so no work estimate is given */
+        status |= run_kernel(cfg, "goal_symnmf", goal_symnmf, &in, in.k, 0.0, 0.0);
+        free_matrix(in.H, n);
+        free_matrix(in.H0, n);
+        in.H0 = NULL;
+    }
+
+    free_matrix(in.X, n);
+    free_matrix(in.W, n);
+    remove(path);
+    return status;
+}
+
+static double rate(double amount, double seconds){
+    return (amount > 0.0 && seconds > 0.0) ? amount / seconds * 1e-9 : 0.0;
+}
+
+static void peak_chunk(const int begin, const int end, const int tid, void *arg){
+    double *partial = (double *)arg;
+    double a0 = 0.0, a1 = 0.1, a2 = 0.2, a3 = 0.3, a4 = 0.4, a5 = 0.5, a6 = 0.6, a7 = 0.7;
+    double scale = 0.999999, offset = 1e-7;
+    long i;
+    (void)begin;
+    (void)end;
+
+    /* eight independent chains hide the multiply-add latency */
+    for (i = 0; i < PEAK_ITERS; i++) {
+        a0 = a0 * scale + offset;
+        a1 = a1 * scale + offset;
+        a2 = a2 * scale + offset;
+        a3 = a3 * scale + offset;
+        a4 = a4 * scale + offset;
+        a5 = a5 * scale + offset;
+        a6 = a6 * scale + offset;
+        a7 = a7 * scale + offset;
+    }
+    partial[tid] = a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+}
+
+static void triad_fill(const int begin, const int end, const int tid, void *arg){
+    triad_ctx *ctx = (triad_ctx *)arg;
+    int i;
+    (void)tid;
+    for (i = begin; i < end; i++) {
+        ctx->a[i] = 0.0;
+        ctx->b[i] = 1.0;
+        ctx->c[i] = 2.0;
+    }
+}
+
+static void triad_chunk(const int begin, const int end, const int tid, void *arg){
+    triad_ctx *ctx = (triad_ctx *)arg;
+    int i;
+    (void)tid;
+    for (i = begin; i < end; i++) {
+        ctx->a[i] = ctx->b[i] + 3.0 * ctx->c[i];
+    }
+}
+
+/**
+ * @brief Measure the roofline of this build on the given number of threads.
+ *
+ * The peak is the best rate of independent multiply-add chains, the
+ * bandwidth the best STREAM triad rate counting 24 bytes per element. Both
+ * are compiled with the same flags as the kernels they bound.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int measure_roofline(const int threads){
+    int r;
+    double start, elapsed, best;
+    double *partial = (double *)malloc(threads * sizeof(double));
+    triad_ctx ctx;
+
+    ctx.a = (double *)malloc(3 * TRIAD_LEN * sizeof(double));
+    if (partial == NULL || ctx.a == NULL) {
+        free(partial);
+        free(ctx.a);
+        return 1;
+    }
+    ctx.b = ctx.a + TRIAD_LEN;
+    ctx.c = ctx.b + TRIAD_LEN;
+
+    best = -1.0;
+    for (r = 0; r < ROOFLINE_REPS; r++) {
+        start = now_seconds();
+        parallel_for(threads, threads, peak_chunk, partial);
+        elapsed = now_seconds() - start;
+        best = best < 0.0 || elapsed < best ? elapsed : best;
+        bench_sink += partial[0];
+    }
+    roofline.flops = 16.0 * PEAK_ITERS * threads / best;
+
+    parallel_for(TRIAD_LEN, threads, triad_fill, &ctx);
+    best = -1.0;
+    for (r = 0; r < ROOFLINE_REPS; r++) {
+        start = now_seconds();
+        parallel_for(TRIAD_LEN, threads, triad_chunk, &ctx);
+        elapsed = now_seconds() - start;
+        best = best < 0.0 || elapsed < best ? elapsed : best;
+        bench_sink += ctx.a[TRIAD_LEN - 1];
+    }
+    roofline.bytes = 24.0 * TRIAD_LEN / best;
+
+    fprintf(stderr, "roofline         peak %.3f GFLOP/s, triad %.3f GB/s on %d threads\n", roofline.flops * 1e-9,
+            roofline.bytes * 1e-9, threads);
+    free(partial);
+    free(ctx.a);
+    return 0;
+}
+
+/**
+ * @brief Place a result under the measured roofline.
+ *
+ * @param r Result to place.
+ * @param intensity Output flops per byte, 0 for a kernel without flops.
+ * @param attainable Output FLOP/s the roofline allows at that intensity, or
+ *                   the bandwidth in bytes/s for a kernel without flops.
+ * @return Achieved fraction of attainable, 0 when unknown.
+ */
+static double roofline_fraction(const bench_result *r, double *intensity, double *attainable){
+    *intensity = r->bytes > 0.0 ? r->flops / r->bytes : 0.0;
+    if (r->flops <= 0.0) {
+        *attainable = r->bytes > 0.0 ? roofline.bytes : 0.0;
+        return r->bytes > 0.0 && r->best > 0.0 ? r->bytes / r->best / roofline.bytes : 0.0;
+    }
+    *attainable = *intensity * roofline.bytes < roofline.flops ? *intensity * roofline.bytes : roofline.flops;
+    return r->best > 0.0 ? r->flops / r->best / *attainable : 0.0;
+}
+
+/**
+ * @brief Whether the roofline at the kernel's intensity is set by bandwidth or by the peak.
+ */
+static const char *roofline_bound(const bench_result *r){
+    if (r->flops <= 0.0 || r->bytes <= 0.0) {
+        return r->bytes > 0.0 ? "memory" : "unknown";
+    }
+    return r->flops / r->bytes * roofline.bytes < roofline.flops ? "memory" : "compute";
+}
+
+static double instructions_per_cycle(const bench_result *r){
+    if (r->counters[PERF_CYCLES] <= 0.0 || r->counters[PERF_INSTRUCTIONS] < 0.0) {
+        return -1.0;
+    }
+    return r->counters[PERF_INSTRUCTIONS] / r->counters[PERF_CYCLES];
+}
+
+static void write_csv(FILE *out, const bench_config *cfg){
+    int i, c;
+    double intensity, attainable, fraction;
+    bench_result *r;
+    fprintf(out, "kernel,n,d,k,reps,best_s,mean_s,gflops,gbytes_per_s,baseline_s");
+    if (cfg->profile) {
+        for (c = 0; c < PERF_COUNTER_COUNT; c++) {
+            fprintf(out, ",%s", perf_counter_name(c));
+        }
+        fprintf(out, ",ipc,intensity,roofline,roofline_fraction,bound");
+    }
+    fprintf(out, "\n");
+    for (i = 0; i < results_count; i++) {
+        r = &results[i];
+        fprintf(out, "%s,%d,%d,%d,%d,%.9f,%.9f,%.6f,%.6f,%.9f", r->name, r->n, r->d, r->k, r->reps,
+                r->best, r->mean, rate(r->flops, r->best), rate(r->bytes, r->best), r->baseline);
+        if (cfg->profile) {
+            for (c = 0; c < PERF_COUNTER_COUNT; c++) {
+                fprintf(out, ",%.0f", r->counters[c]);
+            }
+            fraction = roofline_fraction(r, &intensity, &attainable);
+            fprintf(out, ",%.4f,%.6f,%.6f,%.4f,%s", instructions_per_cycle(r), intensity, attainable * 1e-9,
+                    fraction, roofline_bound(r));
+        }
+        fprintf(out, "\n");
+    }
+}
+
+static void write_json(FILE *out, const bench_config *cfg){
+    int i, c;
+    double intensity, attainable, fraction;
+    bench_result *r;
+    fprintf(out, "{\n  \"warmup\": %d,\n  \"reps\": %d,\n  \"threads\": %d,\n  \"tile\": %d,\n", cfg->warmup,
+            cfg->reps, cfg->threads, cfg->tile);
+    if (cfg->profile) {
+        fprintf(out, "  \"roofline\": {\"peak_gflops\": %.6f, \"gbytes_per_s\": %.6f},\n", roofline.flops * 1e-9,
+                roofline.bytes * 1e-9);
+    }
+    fprintf(out, "  \"results\": [\n");
+    for (i = 0; i < results_count; i++) {
+        r = &results[i];
+        fprintf(out, "    {\"kernel\": \"%s\", \"n\": %d, \"d\": %d, \"k\": %d, \"reps\": %d, "
+                     "\"best_s\": %.9f, \"mean_s\": %.9f, \"gflops\": %.6f, \"gbytes_per_s\": %.6f",
+                r->name, r->n, r->d, r->k, r->reps, r->best, r->mean,
+                rate(r->flops, r->best), rate(r->bytes, r->best));
+        if (r->baseline > 0.0) {
+            fprintf(out, ", \"baseline_s\": %.9f, \"slowdown\": %.4f", r->baseline, r->best / r->baseline);
+        }
+        if (cfg->profile) {
+            /* counters the CPU or kernel does not provide are left out */
+            for (c = 0; c < PERF_COUNTER_COUNT; c++) {
+                if (r->counters[c] >= 0.0) {
+                    fprintf(out, ", \"%s\": %.0f", perf_counter_name(c), r->counters[c]);
+                }
+            }
+            if (instructions_per_cycle(r) >= 0.0) {
+                fprintf(out, ", \"ipc\": %.4f", instructions_per_cycle(r));
+            }
+            fraction = roofline_fraction(r, &intensity, &attainable);
+            fprintf(out, ", \"intensity\": %.6f, \"roofline\": %.6f, \"roofline_fraction\": %.4f, "
+                         "\"bound\": \"%s\"", intensity, attainable * 1e-9, fraction, roofline_bound(r));
+        }
+        fprintf(out, "}%s\n", i < results_count - 1 ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+/**
+ * @brief Match the results against a CSV baseline written by a previous run.
+ *
+ * @return Number of kernels slower than the baseline by more than the threshold,
+ *         or -1 if the baseline could not be read.
+ */
+static int compare_baseline(const bench_config *cfg){
+    FILE *file;
+    char line[512], name[NAME_LEN];
+    int i, n, d, k, reps, slowdowns = 0;
+    double best;
+
+    file = fopen(cfg->compare, "r");
+    if (file == NULL || fgets(line, sizeof(line), file) == NULL) {
+        if (file != NULL) {
+            fclose(file);
+        }
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "%31[^,],%d,%d,%d,%d,%lf", name, &n, &d, &k, &reps, &best) != 6) {
+            continue;
+        }
+        for (i = 0; i < results_count; i++) {
+            if (strcmp(results[i].name, name) == 0 && results[i].n == n
+                && results[i].d == d && results[i].k == k) {
+                results[i].baseline = best;
+            }
+        }
+    }
+    fclose(file);
+
+    for (i = 0; i < results_count; i++) {
+        if (results[i].baseline > 0.0 && results[i].best > results[i].baseline * (1.0 + cfg->threshold)) {
+            fprintf(stderr, "SLOWDOWN %s n=%d d=%d k=%d: %.6fs vs baseline %.6fs (%.1f%%)\n",
+                    results[i].name, results[i].n, results[i].d, results[i].k, results[i].best,
+                    results[i].baseline, 100.0 * (results[i].best / results[i].baseline - 1.0));
+            slowdowns++;
+        }
+    }
+    return slowdowns;
+}
+
+static void usage(const char *prog){
+    fprintf(stderr,
+            "usage: %s [-n N,..] [-d D,..] [-k K,..] [-w warmup] [-r reps] [-f json|csv]\n"
+            "          [-o output] [-c baseline.csv] [-t threshold] [-p data_dir] [-j threads]\n"
+            "          [-s tile] [-P]\n", prog);
+}
+
+/**
+ * @brief Parse the command line into cfg.
+ *
+ * @return 0 on success, 1 on invalid arguments.
+ */
+static int parse_args(int argc, char *argv[], bench_config *cfg){
+    int i;
+    const char *opt, *arg;
+
+    for (i = 1; i < argc; i++) {
+        opt = argv[i];
+        if (strcmp(opt, "-P") == 0) {
+            cfg->profile = 1;
+            continue;
+        }
+        if (opt[0] != '-' || opt[1] == '\0' || opt[2] != '\0' || i + 1 >= argc) {
+            return 1;
+        }
+        arg = argv[++i];
+        switch (opt[1]) {
+            case 'n':
+                cfg->n_count = parse_int_list(arg, cfg->ns);
+                break;
+            case 'd':
+                cfg->d_count = parse_int_list(arg, cfg->ds);
+                break;
+            case 'k':
+                cfg->k_count = parse_int_list(arg, cfg->ks);
+                break;
+            case 'w':
+                cfg->warmup = atoi(arg);
+                break;
+            case 'r':
+                cfg->reps = atoi(arg);
+                break;
+            case 'f':
+                if (strcmp(arg, "json") == 0) {
+                    cfg->format = FORMAT_JSON;
+                } else if (strcmp(arg, "csv") == 0) {
+                    cfg->format = FORMAT_CSV;
+                } else {
+                    return 1;
+                }
+                break;
+            case 'o':
+                cfg->output = arg;
+                break;
+            case 'c':
+                cfg->compare = arg;
+                break;
+            case 't':
+                cfg->threshold = atof(arg);
+                break;
+            case 'p':
+                cfg->data_dir = arg;
+                break;
+            case 'j':
+                cfg->threads = atoi(arg);
+                break;
+            case 's':
+                cfg->tile = atoi(arg);
+                break;
+            default:
+                return 1;
+        }
+    }
+    return cfg->n_count == 0 || cfg->d_count == 0 || cfg->k_count == 0
+           || cfg->warmup < 0 || cfg->reps <= 0 || cfg->threshold < 0.0 || cfg->tile < 0;
+}
+
+int main(int argc, char *argv[]){
+    int i, j, slowdowns = 0;
+    FILE *out = stdout;
+    bench_config cfg;
+
+    cfg.ns[0] = 100;
+    cfg.ns[1] = 200;
+    cfg.ns[2] = 400;
+    cfg.n_count = 3;
+    cfg.ds[0] = 2;
+    cfg.ds[1] = 8;
+    cfg.d_count = 2;
+    cfg.ks[0] = 2;
+    cfg.ks[1] = 5;
+    cfg.k_count = 2;
+    cfg.warmup = DEFAULT_WARMUP;
+    cfg.reps = DEFAULT_REPS;
+    cfg.format = FORMAT_JSON;
+    cfg.output = NULL;
+    cfg.compare = NULL;
+    cfg.data_dir = ".";
+    cfg.threshold = DEFAULT_THRESHOLD;
+    cfg.threads = 1;
+    cfg.tile = 0;
+    cfg.profile = 0;
+
+    if (parse_args(argc, argv, &cfg) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    placement_configure(PAGES_DEFAULT, cfg.threads);
+    tiles_configure(cfg.tile);
+    if (cfg.profile) {
+        if (perf_counters_open(&counters) < PERF_COUNTER_COUNT) {
+            fprintf(stderr, "some hardware counters are unavailable and will be reported as -1\n");
+        }
+        if (measure_roofline(placement_threads()) != 0) {
+            printf("%s\n", ERROR_MESSAGE);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < cfg.n_count; i++) {
+        for (j = 0; j < cfg.d_count; j++) {
+            if (run_point(&cfg, cfg.ns[i], cfg.ds[j]) != 0) {
+                printf("%s\n", ERROR_MESSAGE);
+                return 1;
+            }
+        }
+    }
+
+    if (cfg.compare != NULL) {
+        slowdowns = compare_baseline(&cfg);
+        if (slowdowns < 0) {
+            printf("%s\n", ERROR_MESSAGE);
+            return 1;
+        }
+    }
+
+    if (cfg.output != NULL) {
+        out = fopen(cfg.output, "w");
+        if (out == NULL) {
+            printf("%s\n", ERROR_MESSAGE);
+            return 1;
+        }
+    }
+    if (cfg.format == FORMAT_CSV) {
+        write_csv(out, &cfg);
+    } else {
+        write_json(out, &cfg);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    if (cfg.profile) {
+        perf_counters_close(&counters);
+    }
+    return slowdowns > 0 ? 2 : 0;
+}
@@ -0,0 +1,156 @@
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mat_utils.h"
+#include "checkpoint.h"
+
+/* H slots start on a page boundary so the header can be synced on its own. */
+#define CHECKPOINT_PAGE 4096
+
+static size_t header_bytes(void){
+    return (sizeof(checkpoint_header) + CHECKPOINT_PAGE - 1) / CHECKPOINT_PAGE * CHECKPOINT_PAGE;
+}
+
+static size_t checkpoint_bytes(const int n, const int k, const int has_W){
+    size_t size = header_bytes() + 2 * (size_t)n * k * sizeof(double);
+    if (has_W) {
+        size += (size_t)n * n * sizeof(double);
+    }
+    return size;
+}
+
+/**
+ * @brief Map cp->fd and point the header, slots and W into the mapping.
+ *
+ * @return 0 on success, 1 on failure (the file descriptor is closed).
+ */
+static int checkpoint_map(checkpoint *cp, size_t size, const int n, const int k){
+    char *base;
+    cp->size = size;
+    cp->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cp->fd, 0);
+    if (cp->map == MAP_FAILED) {
+        close(cp->fd);
+        return 1;
+    }
+    base = (char *)cp->map;
+    cp->header = (checkpoint_header *)base;
+    cp->slots[0] = (double *)(base + header_bytes());
+    cp->slots[1] = cp->slots[0] + (size_t)n * k;
+    cp->W = cp->slots[1] + (size_t)n * k;
+    return 0;
+}
+
+static void copy_to_slot(double *slot, double **mat, const int rows, const int cols){
+    int i;
+    for (i = 0; i < rows; i++) {
+        memcpy(slot + (size_t)i * cols, mat[i], cols * sizeof(double));
+    }
+}
+
+static void copy_from_slot(double **mat, const double *slot, const int rows, const int cols){
+    int i;
+    for (i = 0; i < rows; i++) {
+        memcpy(mat[i], slot + (size_t)i * cols, cols * sizeof(double));
+    }
+}
+
+int checkpoint_create(checkpoint *cp, const char *path, const int n, const int k, double **W){
+    size_t size = checkpoint_bytes(n, k, W != NULL);
+    checkpoint_header *header;
+
+    cp->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (cp->fd < 0) {
+        return 1;
+    }
+    if (ftruncate(cp->fd, (off_t)size) != 0) {
+        close(cp->fd);
+        return 1;
+    }
+    if (checkpoint_map(cp, size, n, k) != 0) {
+        return 1;
+    }
+
+    header = cp->header;
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic));
+    header->version = CHECKPOINT_VERSION;
+    header->n = n;
+    header->k = k;
+    header->iteration = 0;
+    header->active_slot = 0;
+    header->has_W = W != NULL;
+    header->finished = 0;
+    memset(header->delta, 0, sizeof(header->delta));
+    if (W != NULL) {
+        copy_to_slot(cp->W, W, n, n);
+    }
+    if (msync(cp->map, size, MS_SYNC) != 0) {
+        checkpoint_close(cp);
+        return 1;
+    }
+    return 0;
+}
+
+int checkpoint_open(checkpoint *cp, const char *path){
+    struct stat st;
+    checkpoint_header header;
+
+    cp->fd = open(path, O_RDWR);
+    if (cp->fd < 0) {
+        return 1;
+    }
+    if (fstat(cp->fd, &st) != 0 || (size_t)st.st_size < sizeof(header)
+        || read(cp->fd, &header, sizeof(header)) != (ssize_t)sizeof(header)
+        || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0
+        || header.version != CHECKPOINT_VERSION || header.n <= 0 || header.k <= 0
+        || header.iteration < 0 || header.iteration > MAX_ITER
+        /* a torn or corrupt header must not index outside the two H slots */
+        || (header.active_slot != 0 && header.active_slot != 1)
+        || (header.has_W != 0 && header.has_W != 1)
+        || (header.finished != 0 && header.finished != 1)
+        || (size_t)st.st_size != checkpoint_bytes(header.n, header.k, header.has_W)) {
+        close(cp->fd);
+        return 1;
+    }
+    return checkpoint_map(cp, (size_t)st.st_size, header.n, header.k);
+}
+
+int checkpoint_save(checkpoint *cp, double **H, const int iteration, const double *delta, const int finished){
+    checkpoint_header *header = cp->header;
+    int slot = 1 - header->active_slot;
+    size_t slot_bytes = (size_t)header->n * header->k * sizeof(double);
+    char *slot_page;
+
+    copy_to_slot(cp->slots[slot], H, header->n, header->k);
+    /* msync needs a page aligned start; both slots start inside the same page run */
+    slot_page = (char *)cp->map + header_bytes();
+    if (msync(slot_page, 2 * slot_bytes, MS_SYNC) != 0) {
+        return 1;
+    }
+
+    memcpy(header->delta, delta, iteration * sizeof(double));
+    header->iteration = iteration;
+    header->finished = finished != 0;
+    header->active_slot = slot;
+    return msync(cp->map, header_bytes(), MS_SYNC) != 0;
+}
+
+void checkpoint_load_H(const checkpoint *cp, double **H){
+    copy_from_slot(H, cp->slots[cp->header->active_slot], cp->header->n, cp->header->k);
+}
+
+int checkpoint_load_W(const checkpoint *cp, double **W){
+    if (!cp->header->has_W) {
+        return 1;
+    }
+    copy_from_slot(W, cp->W, cp->header->n, cp->header->n);
+    return 0;
+}
+
+void checkpoint_close(checkpoint *cp){
+    munmap(cp->map, cp->size);
+    close(cp->fd);
+}
@@ -0,0 +1,92 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdlib.h>
+#include "stats.h"
+
+#define CHECKPOINT_MAGIC "SYMNMFCK"
+#define CHECKPOINT_VERSION 1
+#define DEFAULT_CHECKPOINT_INTERVAL 10
+
+/**
+ * @brief On-disk header at the start of a checkpoint file.
+ *
+ * The header is followed by two n x k slots for H and, when has_W is set,
+ * by the n x n matrix W. A save writes the inactive slot, syncs it, and
+ * only then flips active_slot, so a crash mid-save leaves the previous
+ * checkpoint intact.
+ */
+typedef struct {
+    char magic[8];
+    int version;
+    int n, k;
+    int iteration;
+    int active_slot;
+    int has_W;
+    int finished;
+    double delta[MAX_ITER];
+} checkpoint_header;
+
+/**
+ * @brief A checkpoint file mapped into memory.
+ */
+typedef struct {
+    int fd;
+    void *map;
+    size_t size;
+    checkpoint_header *header;
+    double *slots[2];
+    double *W;
+} checkpoint;
+
+/**
+ * @brief Create (or truncate) a checkpoint file for an n x k factorization.
+ *
+ * @param cp Checkpoint to initialize.
+ * @param path File to create.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param W Normalized similarity matrix to persist for resume, NULL to not persist it.
+ * @return 0 on success, 1 on failure.
+ */
+int checkpoint_create(checkpoint *cp, const char *path, const int n, const int k, double **W);
+
+/**
+ * @brief Map an existing checkpoint file for resume.
+ *
+ * @param cp Checkpoint to initialize.
+ * @param path File to open.
+ * @return 0 on success, 1 if the file is missing or is not a valid checkpoint.
+ */
+int checkpoint_open(checkpoint *cp, const char *path);
+
+/**
+ * @brief Persist H, the iteration counter and the convergence history.
+ *
+ * @param cp Checkpoint to write to.
+ * @param H Current H.
+ * @param iteration Number of iterations completed.
+ * @param delta ||H_new - H_old||_F^2 of each completed iteration, indexed from 0.
+ * @param finished Nonzero once symnmf has converged or hit MAX_ITER.
+ * @return 0 on success, 1 if syncing to disk failed.
+ */
+int checkpoint_save(checkpoint *cp, double **H, const int iteration, const double *delta, const int finished);
+
+/**
+ * @brief Copy the last saved H into a preallocated n x k matrix.
+ */
+void checkpoint_load_H(const checkpoint *cp, double **H);
+
+/**
+ * @brief Copy the persisted W into a preallocated n x n matrix.
+ *
+ * @return 0 on success, 1 if the checkpoint has no W.
+ */
+int checkpoint_load_W(const checkpoint *cp, double **W);
+
+/**
+ * @brief Unmap and close the checkpoint file.
+ */
+void checkpoint_close(checkpoint *cp);
+
+#endif
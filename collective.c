@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "collective.h"
+
+/* Polls of a waiting rank that only yield the CPU, before it starts sleeping between polls. */
+#define COLLECTIVE_SPINS 100
+/* Sleep between the later polls, after each of which the rank checks that its group is alive. */
+#define COLLECTIVE_PAUSE_NSEC 100000L
+
+struct collective_region {
+    /*
+     * A generation barrier that is polled rather than waited on with a
+     * condition variable: a rank killed inside pthread_cond_wait can leave
+     * the condition variable blocking every later broadcast. The lock is
+     * robust, so a rank dying while holding it aborts the group instead.
+     */
+    pthread_mutex_t lock;
+    int waiting;
+    long generation;
+    int aborted;
+    pid_t parent;
+    int size;
+    int process_shared;
+    size_t bytes;
+    double *buffer;
+};
+
+void collective_rows(const int n, const int size, const int rank, int *begin, int *end){
+    *begin = (int)((double)n * rank / size);
+    *end = (int)((double)n * (rank + 1) / size);
+}
+
+/**
+ * @brief Lock the barrier, giving up on the group if the last owner died holding it.
+ */
+static void lock_region(collective_region *region){
+    if (pthread_mutex_lock(&region->lock) == EOWNERDEAD) {
+        region->aborted = 1;
+        pthread_mutex_consistent(&region->lock);
+    }
+}
+
+/**
+ * @brief Whether the calling rank is a forked process whose parent (rank 0) has exited.
+ */
+static int orphaned(const collective_region *region){
+    return region->process_shared && getpid() != region->parent && getppid() != region->parent;
+}
+
+static int shared_barrier(collective *c){
+    collective_region *region = (collective_region *)c->impl;
+    struct timespec pause;
+    long generation;
+    int polls, passed;
+
+    pause.tv_sec = 0;
+    pause.tv_nsec = COLLECTIVE_PAUSE_NSEC;
+    lock_region(region);
+    generation = region->generation;
+    if (!region->aborted && ++region->waiting == region->size) {
+        region->waiting = 0;
+        region->generation++;
+    }
+    for (polls = 0; region->generation == generation && !region->aborted; polls++) {
+        pthread_mutex_unlock(&region->lock);
+        if (polls < COLLECTIVE_SPINS) {
+            sched_yield();
+        } else {
+            nanosleep(&pause, NULL);
+        }
+        lock_region(region);
+        if (polls >= COLLECTIVE_SPINS && orphaned(region)) {
+            region->aborted = 1;
+        }
+    }
+    /* a barrier every rank reached before the abort still counts as passed */
+    passed = region->generation != generation;
+    pthread_mutex_unlock(&region->lock);
+    return !passed;
+}
+
+static int shared_allgather_rows(collective *c, double **mat, const int n, const int cols){
+    collective_region *region = (collective_region *)c->impl;
+    int i, begin, end;
+    size_t row_bytes = cols * sizeof(double);
+
+    collective_rows(n, c->size, c->rank, &begin, &end);
+    for (i = begin; i < end; i++) {
+        memcpy(region->buffer + (size_t)i * cols, mat[i], row_bytes);
+    }
+    if (shared_barrier(c) != 0) {
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        if (i < begin || i >= end) {
+            memcpy(mat[i], region->buffer + (size_t)i * cols, row_bytes);
+        }
+    }
+    /* nobody may reuse the buffer until every rank has read it */
+    return shared_barrier(c);
+}
+
+static int shared_allreduce_sum(collective *c, double *values, const int count){
+    collective_region *region = (collective_region *)c->impl;
+    int r, i;
+
+    memcpy(region->buffer + (size_t)c->rank * count, values, count * sizeof(double));
+    if (shared_barrier(c) != 0) {
+        return 1;
+    }
+    for (i = 0; i < count; i++) {
+        values[i] = 0.0;
+        for (r = 0; r < c->size; r++) {
+            values[i] += region->buffer[(size_t)r * count + i];
+        }
+    }
+    return shared_barrier(c);
+}
+
+static int shared_broadcast(collective *c, double *values, const int count, const int root){
+    collective_region *region = (collective_region *)c->impl;
+
+    if (c->rank == root) {
+        memcpy(region->buffer, values, count * sizeof(double));
+    }
+    if (shared_barrier(c) != 0) {
+        return 1;
+    }
+    if (c->rank != root) {
+        memcpy(values, region->buffer, count * sizeof(double));
+    }
+    return shared_barrier(c);
+}
+
+/**
+ * @brief Free the memory of a region, which holds no initialized lock.
+ */
+static void release_region(collective_region *region){
+    if (region->process_shared) {
+        munmap(region, region->bytes);
+    } else {
+        free(region);
+    }
+}
+
+static void shared_abort(collective *c){
+    collective_shared_abort((collective_region *)c->impl);
+}
+
+static const collective_ops shared_ops = {
+    shared_barrier,
+    shared_allgather_rows,
+    shared_allreduce_sum,
+    shared_broadcast,
+    shared_abort
+};
+
+collective_region *collective_shared_create(const int size, const size_t capacity, const int process_shared){
+    collective_region *region;
+    pthread_mutexattr_t attr;
+    size_t bytes = sizeof(collective_region) + capacity * sizeof(double);
+    void *block;
+
+    if (process_shared) {
+        block = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        block = block == MAP_FAILED ? NULL : block;
+    } else {
+        block = malloc(bytes);
+    }
+    if (block == NULL) {
+        return NULL;
+    }
+    region = (collective_region *)block;
+    region->waiting = 0;
+    region->generation = 0;
+    region->aborted = 0;
+    region->parent = getpid();
+    region->size = size;
+    region->process_shared = process_shared;
+    region->bytes = bytes;
+    region->buffer = (double *)(region + 1);
+
+    if (pthread_mutexattr_init(&attr) != 0) {
+        release_region(region);
+        return NULL;
+    }
+    if (pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) != 0
+        || (process_shared && pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) != 0)
+        || pthread_mutex_init(&region->lock, &attr) != 0) {
+        pthread_mutexattr_destroy(&attr);
+        release_region(region);
+        return NULL;
+    }
+    pthread_mutexattr_destroy(&attr);
+    return region;
+}
+
+void collective_shared_attach(collective *c, collective_region *region, const int rank){
+    c->rank = rank;
+    c->size = region->size;
+    c->ops = &shared_ops;
+    c->impl = region;
+}
+
+void collective_shared_abort(collective_region *region){
+    lock_region(region);
+    region->aborted = 1;
+    pthread_mutex_unlock(&region->lock);
+}
+
+void collective_shared_destroy(collective_region *region){
+    if (region == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&region->lock);
+    release_region(region);
+}
@@ -0,0 +1,107 @@
+#ifndef COLLECTIVE_H
+#define COLLECTIVE_H
+
+#include <stdlib.h>
+
+/**
+ * @brief One rank's handle on a group of ranks running the same program, MPI style.
+ *
+ * Every rank must make the same sequence of collective calls with the same
+ * sizes. Every call returns 0 on success and 1 once the group has been
+ * aborted, after which the data exchanged is meaningless and the rank
+ * should give up. The operations are behind a table of function pointers so that a
+ * transport other than shared memory (e.g. MPI across nodes) can be added
+ * without touching the code that uses them.
+ */
+typedef struct collective collective;
+
+typedef struct {
+    /**
+     * @brief Wait until every rank has reached the barrier.
+     */
+    int (*barrier)(collective *c);
+
+    /**
+     * @brief In-place allgather of the rows of an n x cols matrix.
+     *
+     * On entry each rank holds the rows it owns (see collective_rows); on
+     * return every rank holds all n rows.
+     */
+    int (*allgather_rows)(collective *c, double **mat, const int n, const int cols);
+
+    /**
+     * @brief Element-wise sum of values across ranks, stored back on every rank.
+     *
+     * The partial sums are added in rank order, so every rank gets the same bits.
+     */
+    int (*allreduce_sum)(collective *c, double *values, const int count);
+
+    /**
+     * @brief Copy values from root to every other rank.
+     */
+    int (*broadcast)(collective *c, double *values, const int count, const int root);
+
+    /**
+     * @brief Give up on the group: every rank's current and later collective calls fail.
+     *
+     * For a rank that cannot go on, so the others do not wait for it.
+     */
+    void (*abort)(collective *c);
+} collective_ops;
+
+struct collective {
+    int rank;
+    int size;
+    const collective_ops *ops;
+    void *impl;
+};
+
+/**
+ * @brief Shared state of the shared-memory transport, see collective_shared_create.
+ */
+typedef struct collective_region collective_region;
+
+/**
+ * @brief Rows [begin, end) of an n-row matrix owned by rank, the same partition as parallel_for.
+ */
+void collective_rows(const int n, const int size, const int rank, int *begin, int *end);
+
+/**
+ * @brief Create the shared memory used by size ranks to communicate.
+ *
+ * With process_shared set, the region is an anonymous shared mapping and
+ * its barrier is process-shared, so it must be created before forking the
+ * ranks. Otherwise it is ordinary heap memory for ranks that are threads
+ * of one process (the loopback transport).
+ *
+ * A rank waiting at the barrier polls it, first yielding the CPU and then
+ * sleeping 100 us between polls. A forked rank whose creator has exited
+ * aborts the group, and so does any rank finding that a rank died while
+ * holding the barrier's lock. Any other failure, e.g. a forked rank that
+ * crashed, is reported with collective_shared_abort.
+ *
+ * @param size Number of ranks.
+ * @param capacity Number of doubles one collective call may exchange in
+ *                 total: n * cols for allgather_rows, size * count for
+ *                 allreduce_sum and count for broadcast.
+ * @param process_shared Nonzero if the ranks are separate processes.
+ * @return The region, NULL on failure.
+ */
+collective_region *collective_shared_create(const int size, const size_t capacity, const int process_shared);
+
+/**
+ * @brief Bind rank to a region created by collective_shared_create.
+ */
+void collective_shared_attach(collective *c, collective_region *region, const int rank);
+
+/**
+ * @brief Abort the group: every rank waiting at the barrier, or reaching it later, fails.
+ */
+void collective_shared_abort(collective_region *region);
+
+/**
+ * @brief Release a region once no rank uses it anymore.
+ */
+void collective_shared_destroy(collective_region *region);
+
+#endif
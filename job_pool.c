@@ -0,0 +1,279 @@
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
+#include "job_pool.h"
+
+/**
+ * @brief Free a job and everything it owns. Called with the last reference.
+ */
+static void job_free(job *j){
+    if (j->result != j->H) {
+        free_matrix(j->result, j->result_rows);
+    }
+    free_matrix(j->X, j->n);
+    free_matrix(j->H, j->n);
+    free_matrix(j->W, j->n);
+    free(j);
+}
+
+/**
+ * @brief Drop one reference. The pool lock must be held if the job was submitted.
+ */
+static void job_unref(job *j){
+    if (--j->refcount == 0) {
+        job_free(j);
+    }
+}
+
+/**
+ * @brief symnmf iteration callback: publishes progress and checks for cancellation.
+ */
+static int job_iter_callback(int iter, double objective, double delta, void *user){
+    job *j = (job *)user;
+    int stop;
+    (void)objective;
+    (void)delta;
+
+    pthread_mutex_lock(&j->pool->lock);
+    j->iterations = iter + 1;
+    stop = j->cancel_requested || j->pool->shutdown;
+    pthread_mutex_unlock(&j->pool->lock);
+    return stop;
+}
+
+/**
+ * @brief Run a job without holding the pool lock.
+ *
+ * @return The new job state.
+ */
+static enum JobState job_run(job *j){
+    /* allocations are counted per thread, so count from this worker */
+    stats_init(&j->stats, job_iter_callback, j);
+    switch (j->kind) {
+        case JOB_NORM:
+            j->result = norm(j->X, j->n, j->d, NULL);
+            j->result_rows = j->n;
+            j->result_cols = j->n;
+            break;
+        case JOB_SYMNMF:
+            j->result = symnmf(j->H, j->W, j->n, j->k, &j->stats);
+            stats_finish(&j->stats);
+            j->result_rows = j->n;
+            j->result_cols = j->k;
+            if (j->result != NULL && j->stats.interrupted) {
+                return JOB_CANCELLED;
+            }
+            break;
+    }
+    return j->result != NULL ? JOB_DONE : JOB_FAILED;
+}
+
+static void *job_worker(void *arg){
+    job_pool *pool = (job_pool *)arg;
+    job *j;
+    enum JobState state;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->head == NULL) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->head == NULL) {
+            break;
+        }
+        j = pool->head;
+        pool->head = j->next;
+        if (pool->head == NULL) {
+            pool->tail = NULL;
+        }
+        j->next = NULL;
+        j->state = JOB_RUNNING;
+        pthread_mutex_unlock(&pool->lock);
+
+        state = job_run(j);
+
+        pthread_mutex_lock(&pool->lock);
+        j->state = state;
+        pthread_cond_broadcast(&pool->job_finished);
+        job_unref(j);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+job_pool *job_pool_create(int num_threads){
+    int i;
+    job_pool *pool = (job_pool *)malloc(sizeof(job_pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pool->num_threads = 0;
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->job_finished, NULL);
+
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, job_worker, pool) != 0) {
+            job_pool_destroy(pool);
+            return NULL;
+        }
+        pool->num_threads++;
+    }
+    return pool;
+}
+
+void job_pool_destroy(job_pool *pool){
+    int i;
+    job *j;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    while (pool->head != NULL) {
+        j = pool->head;
+        pool->head = j->next;
+        j->state = JOB_CANCELLED;
+        job_unref(j);
+    }
+    pool->tail = NULL;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_cond_broadcast(&pool->job_finished);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->job_finished);
+    free(pool->threads);
+    free(pool);
+}
+
+job *job_create(enum JobKind kind, double **X, double **H, double **W, const int n, const int d){
+    job *j = (job *)malloc(sizeof(job));
+    if (j == NULL) {
+        free_matrix(X, n);
+        free_matrix(H, n);
+        free_matrix(W, n);
+        return NULL;
+    }
+    j->kind = kind;
+    j->state = JOB_PENDING;
+    j->X = X;
+    j->H = H;
+    j->W = W;
+    j->n = n;
+    j->d = kind == JOB_NORM ? d : 0;
+    j->k = kind == JOB_SYMNMF ? d : 0;
+    j->result = NULL;
+    j->result_rows = 0;
+    j->result_cols = 0;
+    j->iterations = 0;
+    j->cancel_requested = 0;
+    j->refcount = 1;
+    j->pool = NULL;
+    j->next = NULL;
+    stats_init(&j->stats, job_iter_callback, j);
+    return j;
+}
+
+void job_pool_submit(job_pool *pool, job *j){
+    pthread_mutex_lock(&pool->lock);
+    j->pool = pool;
+    j->refcount++;
+    if (pool->tail == NULL) {
+        pool->head = j;
+    } else {
+        pool->tail->next = j;
+    }
+    pool->tail = j;
+    pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int job_pool_cancel(job_pool *pool, job *j){
+    int cancelled = 1;
+    job *prev;
+
+    pthread_mutex_lock(&pool->lock);
+    if (j->state == JOB_PENDING) {
+        if (pool->head == j) {
+            pool->head = j->next;
+            prev = NULL;
+        } else {
+            prev = pool->head;
+            while (prev->next != j) {
+                prev = prev->next;
+            }
+            prev->next = j->next;
+        }
+        if (pool->tail == j) {
+            pool->tail = prev;
+        }
+        j->next = NULL;
+        j->state = JOB_CANCELLED;
+        pthread_cond_broadcast(&pool->job_finished);
+        job_unref(j);
+    } else if (j->state == JOB_RUNNING) {
+        j->cancel_requested = 1;
+    } else {
+        cancelled = 0;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return cancelled;
+}
+
+int job_pool_wait(job_pool *pool, job *j, double timeout){
+    struct timespec deadline;
+    int finished;
+
+    if (timeout >= 0.0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)timeout;
+        deadline.tv_nsec += (long)((timeout - (double)(time_t)timeout) * 1e9);
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (j->state == JOB_PENDING || j->state == JOB_RUNNING) {
+        if (timeout < 0.0) {
+            pthread_cond_wait(&pool->job_finished, &pool->lock);
+        } else if (pthread_cond_timedwait(&pool->job_finished, &pool->lock, &deadline) != 0) {
+            break;
+        }
+    }
+    finished = j->state != JOB_PENDING && j->state != JOB_RUNNING;
+    pthread_mutex_unlock(&pool->lock);
+    return finished;
+}
+
+enum JobState job_pool_poll(job_pool *pool, job *j, int *iterations){
+    enum JobState state;
+    pthread_mutex_lock(&pool->lock);
+    state = j->state;
+    if (iterations != NULL) {
+        *iterations = j->iterations;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return state;
+}
+
+void job_release(job_pool *pool, job *j){
+    if (pool == NULL) {
+        job_unref(j);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    job_unref(j);
+    pthread_mutex_unlock(&pool->lock);
+}
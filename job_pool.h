@@ -0,0 +1,133 @@
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <pthread.h>
+#include "symnmf.h"
+
+enum JobKind{
+    JOB_NORM,
+    JOB_SYMNMF
+};
+
+enum JobState{
+    JOB_PENDING,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_FAILED,
+    JOB_CANCELLED
+};
+
+/**
+ * @brief One norm or symnmf computation queued on a job_pool.
+ *
+ * The job owns its input matrices and its result. It is reference counted
+ * so the submitter can keep a handle while the pool runs it; the last
+ * job_release frees everything.
+ *
+ * The placement (placement_configure) and tiling (tiles_configure) settings
+ * are process-wide and are not captured at submission: every running job
+ * reads the current values. Change them only while no job is running.
+ */
+typedef struct job {
+    enum JobKind kind;
+    enum JobState state;
+    double **X, **H, **W;
+    int n, d, k;
+    double **result;
+    int result_rows, result_cols;
+    int iterations;
+    int cancel_requested;
+    int refcount;
+    symnmf_stats stats;
+    struct job_pool *pool;
+    struct job *next;
+} job;
+
+typedef struct job_pool {
+    pthread_t *threads;
+    int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t job_finished;
+    job *head, *tail;
+    int shutdown;
+} job_pool;
+
+/**
+ * @brief Start a pool of worker threads.
+ *
+ * @param num_threads Number of workers, at least 1.
+ * @return The pool, NULL on failure.
+ */
+job_pool *job_pool_create(int num_threads);
+
+/**
+ * @brief Cancel every job, join the workers and free the pool.
+ *
+ * @param pool Pool to destroy.
+ */
+void job_pool_destroy(job_pool *pool);
+
+/**
+ * @brief Create a job holding one reference, owned by the caller.
+ *
+ * @param kind JOB_NORM or JOB_SYMNMF.
+ * @param X Data matrix for JOB_NORM, NULL otherwise. Ownership moves to the job.
+ * @param H Initial H for JOB_SYMNMF, NULL otherwise. Ownership moves to the job.
+ * @param W Normalized similarity matrix for JOB_SYMNMF, NULL otherwise. Ownership moves to the job.
+ * @param n Number of data points.
+ * @param d Dimension of each data point (JOB_NORM) or number of clusters (JOB_SYMNMF).
+ * @return The job, NULL on failure (the matrices are freed).
+ */
+job *job_create(enum JobKind kind, double **X, double **H, double **W, const int n, const int d);
+
+/**
+ * @brief Queue a job. The pool takes its own reference.
+ *
+ * @param pool Pool to run the job on.
+ * @param j Job to queue.
+ */
+void job_pool_submit(job_pool *pool, job *j);
+
+/**
+ * @brief Request cancellation of a job.
+ *
+ * A pending job is removed from the queue; a running symnmf job stops at
+ * the end of its current iteration. A running norm job cannot be
+ * interrupted and completes normally.
+ *
+ * @param pool Pool the job was submitted to.
+ * @param j Job to cancel.
+ * @return 1 if the job was pending or running, 0 if it had already finished.
+ */
+int job_pool_cancel(job_pool *pool, job *j);
+
+/**
+ * @brief Wait for a job to finish.
+ *
+ * @param pool Pool the job was submitted to.
+ * @param j Job to wait for.
+ * @param timeout Seconds to wait, negative to wait forever.
+ * @return 1 if the job finished, 0 on timeout.
+ */
+int job_pool_wait(job_pool *pool, job *j, double timeout);
+
+/**
+ * @brief Read the state and completed iteration count of a job.
+ *
+ * @param pool Pool the job was submitted to.
+ * @param j Job to query.
+ * @param iterations Output, may be NULL.
+ * @return The job state.
+ */
+enum JobState job_pool_poll(job_pool *pool, job *j, int *iterations);
+
+/**
+ * @brief Drop the caller's reference to a job.
+ *
+ * @param pool Pool the job was submitted to, NULL if it never was.
+ * @param j Job to release.
+ */
+void job_release(job_pool *pool, job *j);
+
+#endif
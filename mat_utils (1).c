@@ -1,5 +1,26 @@
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
 #include "mat_utils.h"
 
+/* Allocation counts are kept per thread, so concurrent jobs neither race nor see each other's. */
+static pthread_key_t allocation_key;
+static pthread_once_t allocation_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Stored in front of the row pointers of every matrix, so that
+ *        free_matrix can hand the block back to whoever allocated it.
+ */
+typedef struct {
+    void *block;
+    size_t bytes;
+    matrix_release release;
+} matrix_header;
+
+static void release_heap(void *block, size_t bytes){
+    (void)bytes;
+    free(block);
+}
+
 void calc_mat_difference(double **output, double** mat1, double** mat2, const int rows, const int cols){
     int i, j;
     for (i = 0; i < rows; i++){
@@ -10,11 +31,17 @@ void calc_mat_difference(double **output, double** mat1, double** mat2, const in
 }
 
 double** multiply_matrixes(double** mat1, double** mat2, const int rows1, const int cols1, const int cols2){
-     int i, j, k;
     double **result = allocate_matrix(rows1, cols2);
     if (result == NULL) {
         return NULL;
     }
+    multiply_matrixes_into(result, mat1, mat2, rows1, cols1, cols2);
+    return result;
+}
+
+void multiply_matrixes_into(double **result, double** mat1, double** mat2,
+                            const int rows1, const int cols1, const int cols2){
+    int i, j, k;
     for (i = 0; i < rows1; i++) {
         for (j = 0; j < cols2; j++) {
             result[i][j] = 0.0;
@@ -23,7 +50,6 @@ double** multiply_matrixes(double** mat1, double** mat2, const int rows1, const
             }
         }
     }
-    return result;
 }
 
 void copy_matrix(double **dest, double **src, const int rows, const int cols){
@@ -36,32 +62,42 @@ void copy_matrix(double **dest, double **src, const int rows, const int cols){
 }
 
 double** calc_transpose(double** mat, const int rows, const int cols){
-    int i, j;
     double **transposed = allocate_matrix(cols, rows);
     if (transposed == NULL){
         return NULL;
     }
+    calc_transpose_into(transposed, mat, rows, cols);
+    return transposed;
+}
+
+void calc_transpose_into(double **transposed, double** mat, const int rows, const int cols){
+    int i, j;
     for (i = 0; i < rows; i++){
         for(j = 0; j < cols; j++){
             transposed[j][i] = mat[i][j];
         }
     }
-    return transposed;
 }
 
 double** calc_inverse_sqrt_diagonal(double **D, int n){
-    int i, j;
     double** Q = allocate_matrix(n, n);
     if (Q == NULL){
         return NULL;
     }
+    if (calc_inverse_sqrt_diagonal_into(Q, D, n) != 0) {
+        free_matrix(Q, n);
+        return NULL;
+    }
+    return Q;
+}
 
+int calc_inverse_sqrt_diagonal_into(double **Q, double **D, int n){
+    int i, j;
     for (i = 0; i < n; ++i) {
         for (j = 0; j < n; ++j) {
             if (i == j) {
                 if (D[i][j] == 0) {
-                    printf("Error: Diagonal element is zero, cannot take inverse square root.\n");
-                    exit(1);
+                    return 1;
                 }
                 Q[i][j] = 1.0 / sqrt(D[i][j]);
             } else {
@@ -69,7 +105,7 @@ double** calc_inverse_sqrt_diagonal(double **D, int n){
             }
         }
     }
-    return Q;
+    return 0;
 }
 
 double calc_frobenius_squared_norm(double **mat, const int rows, const int cols){
@@ -105,28 +141,78 @@ void print_matrix(double **matrix, int rows, int cols) {
     }
 }
 
-double **allocate_matrix(int rows, int cols) {
+size_t matrix_block_bytes(int rows, int cols) {
+    return sizeof(matrix_header) + rows * sizeof(double *) + (size_t)rows * cols * sizeof(double);
+}
+
+double **matrix_from_block(void *block, size_t bytes, int rows, int cols, matrix_release release) {
     int i;
-    double **mat = (double **)malloc(rows * sizeof(double *));
-    if (mat == NULL) {
-        return NULL;
-    }
+    double *data;
+    matrix_header *header = (matrix_header *)block;
+    /* header, row pointers and data share one block, so the rows are contiguous */
+    double **mat = (double **)(header + 1);
+
+    header->block = block;
+    header->bytes = bytes;
+    header->release = release;
+    data = (double *)(mat + rows);
     for (i = 0; i < rows; i++) {
-        mat[i] = (double *)malloc(cols * sizeof(double));
-        if (mat[i] == NULL) {
-            free_matrix(mat, rows);
-            return NULL;
-        }
+        mat[i] = data + (size_t)i * cols;
     }
     return mat;
 }
 
+static void create_allocation_key(void) {
+    pthread_key_create(&allocation_key, free);
+}
+
+/**
+ * @brief The calling thread's allocation count, NULL if it cannot be created.
+ */
+static long *allocation_counter(void) {
+    long *count;
+    pthread_once(&allocation_once, create_allocation_key);
+    count = (long *)pthread_getspecific(allocation_key);
+    if (count == NULL) {
+        count = (long *)calloc(1, sizeof(long));
+        if (count != NULL && pthread_setspecific(allocation_key, count) != 0) {
+            free(count);
+            count = NULL;
+        }
+    }
+    return count;
+}
+
+double **allocate_matrix(int rows, int cols) {
+    size_t bytes = matrix_block_bytes(rows, cols);
+    void *block = malloc(bytes);
+    if (block == NULL) {
+        return NULL;
+    }
+    matrix_add_allocations(1);
+    return matrix_from_block(block, bytes, rows, cols, release_heap);
+}
+
+long matrix_allocation_count(void) {
+    long *count = allocation_counter();
+    return count != NULL ? *count : 0;
+}
+
+void matrix_add_allocations(long count) {
+    long *total = allocation_counter();
+    if (total != NULL) {
+        *total += count;
+    }
+}
+
 void free_matrix(double **mat, int rows) {
-    int i;
-    for (i = 0; i < rows; i++) {
-        free(mat[i]);
+    matrix_header *header;
+    (void)rows;
+    if (mat == NULL) {
+        return;
     }
-    free(mat);
+    header = (matrix_header *)mat - 1;
+    header->release(header->block, header->bytes);
 }
 
 int count_dimensions(const char *filename, int *rows, int *cols) {
@@ -30,6 +30,19 @@ void calc_mat_difference(double **output, double** mat1, double** mat2, const in
  */
 double** multiply_matrixes(double** mat1, double** mat2, const int rows1, const int cols1, const int cols2);
 
+/**
+ * @brief Multiply two matrices into a preallocated rows1 x cols2 matrix.
+ *
+ * @param result Output matrix, must not alias the inputs.
+ * @param mat1 First input matrix.
+ * @param mat2 Second input matrix.
+ * @param rows1 Number of rows in the first matrix.
+ * @param cols1 Number of columns in the first matrix.
+ * @param cols2 Number of columns in the second matrix.
+ */
+void multiply_matrixes_into(double **result, double** mat1, double** mat2,
+                            const int rows1, const int cols1, const int cols2);
+
 /**
  * @brief Copy the contents of one matrix to another.
  *
@@ -50,15 +63,35 @@ void copy_matrix(double **dest, double **src, const int rows, const int cols);
  */
 double** calc_transpose(double** mat, const int rows, const int cols);
 
+/**
+ * @brief Calculate the transpose of a matrix into a preallocated cols x rows matrix.
+ *
+ * @param transposed Output matrix.
+ * @param mat Input matrix.
+ * @param rows Number of rows in the input matrix.
+ * @param cols Number of columns in the input matrix.
+ */
+void calc_transpose_into(double **transposed, double** mat, const int rows, const int cols);
+
 /**
  * @brief Given D, diagonal matrix, it calculates D^(-0.5).
  *
  * @param D Diagonal matrix.
  * @param n Dimension of the matrix.
- * @return Resulting matrix after power operation.
+ * @return Resulting matrix after power operation, NULL on failure or if a diagonal element is zero.
  */
 double** calc_inverse_sqrt_diagonal(double **D, int n);
 
+/**
+ * @brief Given D, diagonal matrix, it calculates D^(-0.5) into a preallocated matrix.
+ *
+ * @param Q Output matrix.
+ * @param D Diagonal matrix.
+ * @param n Dimension of the matrix.
+ * @return 0 on success, 1 if a diagonal element is zero (Q is then incomplete).
+ */
+int calc_inverse_sqrt_diagonal_into(double **Q, double **D, int n);
+
 /**
  * @brief Calculate the Frobenius squared norm of a matrix.
  *
@@ -89,7 +122,35 @@ double calc_squared_euclidean_distance(double *x, double *y, int d);
 void print_matrix(double **matrix, int rows, int cols);
 
 /**
- * @brief Allocate memory for a matrix.
+ * @brief Returns a block obtained by a custom allocator, see matrix_from_block.
+ *
+ * @param block Start of the block.
+ * @param bytes Size of the block given to matrix_from_block.
+ */
+typedef void (*matrix_release)(void *block, size_t bytes);
+
+/**
+ * @brief Number of bytes a rows x cols matrix needs, bookkeeping and row pointers included.
+ */
+size_t matrix_block_bytes(int rows, int cols);
+
+/**
+ * @brief Lay out a matrix in a block of at least matrix_block_bytes(rows, cols) bytes.
+ *
+ * The matrix is later freed with free_matrix, which calls release(block, bytes).
+ * The data is not initialized and the allocation is not counted.
+ *
+ * @param block Block to lay the matrix out in.
+ * @param bytes Size of the block, handed back to release.
+ * @param rows Number of rows in the matrix.
+ * @param cols Number of columns in the matrix.
+ * @param release Function that frees the block.
+ * @return The matrix, whose rows are stored contiguously.
+ */
+double **matrix_from_block(void *block, size_t bytes, int rows, int cols, matrix_release release);
+
+/**
+ * @brief Allocate memory for a matrix. The rows are stored contiguously.
  *
  * @param rows Number of rows in the matrix.
  * @param cols Number of columns in the matrix.
@@ -98,7 +159,25 @@ void print_matrix(double **matrix, int rows, int cols);
 double **allocate_matrix(int rows, int cols);
 
 /**
- * @brief Free the allocated memory for a matrix.
+ * @brief Number of heap allocations made for matrices by the calling thread,
+ *        by allocate_matrix and by arena blocks.
+ *
+ * Each thread has its own count, so the difference between two calls on
+ * one thread is not affected by allocations made concurrently elsewhere.
+ *
+ * @return Allocation count.
+ */
+long matrix_allocation_count(void);
+
+/**
+ * @brief Add to the calling thread's count returned by matrix_allocation_count.
+ *
+ * @param count Number of heap allocations made.
+ */
+void matrix_add_allocations(long count);
+
+/**
+ * @brief Free the allocated memory for a matrix. Does nothing for NULL.
  *
  * @param matrix Input matrix.
  * @param rows Number of rows in the matrix.
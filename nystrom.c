@@ -0,0 +1,243 @@
+#include <string.h>
+#include "nystrom.h"
+#include "arena.h"
+
+/* Diagonal shift first tried when M is numerically singular, grown tenfold per retry. */
+#define NYSTROM_JITTER 1e-10
+#define NYSTROM_MAX_JITTER 1e-2
+/* Floor of the approximated degrees, which can undershoot for points far from every landmark. */
+#define NYSTROM_MIN_DEGREE 1e-12
+
+/**
+ * @brief Draw m distinct indices of [0, n) with a partial Fisher-Yates shuffle.
+ */
+static void pick_landmarks(int *landmarks, int *perm, const int n, const int m){
+    int i, j, tmp;
+    for (i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    for (i = 0; i < m; i++) {
+        j = i + (int)((n - i) * ((double)rand() / ((double)RAND_MAX + 1.0)));
+        tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+        landmarks[i] = perm[i];
+    }
+}
+
+/**
+ * @brief Cholesky factor of M + jitter*I into the lower triangle of L.
+ *
+ * @return 0 on success, 1 if the shifted matrix is not positive definite.
+ */
+static int cholesky(double **L, double **M, const int m, const double jitter){
+    int i, j, p;
+    double sum;
+    for (j = 0; j < m; j++) {
+        sum = M[j][j] + jitter;
+        for (p = 0; p < j; p++) {
+            sum -= L[j][p] * L[j][p];
+        }
+        if (sum <= 0.0) {
+            return 1;
+        }
+        L[j][j] = sqrt(sum);
+        for (i = j + 1; i < m; i++) {
+            sum = M[i][j];
+            for (p = 0; p < j; p++) {
+                sum -= L[i][p] * L[j][p];
+            }
+            L[i][j] = sum / L[j][j];
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Overwrite every row c of B with L^-1 c, so that B B^T = C M^-1 C^T.
+ */
+static void solve_rows(double **B, double **L, const int n, const int m){
+    int i, a, p;
+    double sum;
+    for (i = 0; i < n; i++) {
+        for (a = 0; a < m; a++) {
+            sum = B[i][a];
+            for (p = 0; p < a; p++) {
+                sum -= L[a][p] * B[i][p];
+            }
+            B[i][a] = sum / L[a][a];
+        }
+    }
+}
+
+int nystrom_build(nystrom *ny, double **X, const int n, const int d, const int m, symnmf_stats *stats){
+    int i, a, b, size = m < n ? m : n;
+    int *landmarks, *perm;
+    double **M, **L, *colsum, *degree;
+    double start, jitter, sq;
+    arena scratch;
+
+    ny->n = n;
+    ny->m = size;
+    ny->B = NULL;
+    ny->row_norm = NULL;
+    if (size <= 0) {
+        return 1;
+    }
+
+    arena_init(&scratch, 2 * arena_matrix_bytes(size, size) + 2 * (size_t)n * sizeof(double)
+                         + ((size_t)n + size) * sizeof(int));
+    M = arena_matrix(&scratch, size, size);
+    L = arena_matrix(&scratch, size, size);
+    colsum = (double *)arena_alloc(&scratch, size * sizeof(double));
+    degree = (double *)arena_alloc(&scratch, n * sizeof(double));
+    landmarks = (int *)arena_alloc(&scratch, size * sizeof(int));
+    perm = (int *)arena_alloc(&scratch, n * sizeof(int));
+    ny->B = allocate_matrix(n, size);
+    ny->row_norm = (double *)malloc(n * sizeof(double));
+    if (M == NULL || L == NULL || colsum == NULL || degree == NULL || landmarks == NULL || perm == NULL
+        || ny->B == NULL || ny->row_norm == NULL) {
+        nystrom_free(ny);
+        arena_release(&scratch);
+        return 1;
+    }
+
+    /* C and its landmark block M, with the kernel's diagonal of 1 */
+    start = STATS_START(stats);
+    pick_landmarks(landmarks, perm, n, size);
+    for (i = 0; i < n; i++) {
+        for (a = 0; a < size; a++) {
+            ny->B[i][a] = exp(-calc_squared_euclidean_distance(X[i], X[landmarks[a]], d) / 2.0);
+        }
+    }
+    for (a = 0; a < size; a++) {
+        for (b = 0; b < size; b++) {
+            M[a][b] = ny->B[landmarks[a]][b];
+        }
+    }
+    for (jitter = NYSTROM_JITTER; cholesky(L, M, size, jitter) != 0; jitter *= 10.0) {
+        if (jitter > NYSTROM_MAX_JITTER) {
+            nystrom_free(ny);
+            arena_release(&scratch);
+            return 1;
+        }
+    }
+    solve_rows(ny->B, L, n, size);
+    STATS_STOP(stats, PHASE_SYM, start);
+
+    /* degree i is row i of (B B^T - diag) times the ones vector */
+    start = STATS_START(stats);
+    memset(colsum, 0, size * sizeof(double));
+    for (i = 0; i < n; i++) {
+        for (a = 0; a < size; a++) {
+            colsum[a] += ny->B[i][a];
+        }
+    }
+    for (i = 0; i < n; i++) {
+        degree[i] = 0.0;
+        sq = 0.0;
+        for (a = 0; a < size; a++) {
+            degree[i] += ny->B[i][a] * colsum[a];
+            sq += ny->B[i][a] * ny->B[i][a];
+        }
+        degree[i] -= sq;
+        if (degree[i] < NYSTROM_MIN_DEGREE) {
+            degree[i] = NYSTROM_MIN_DEGREE;
+        }
+    }
+    STATS_STOP(stats, PHASE_DEGREE, start);
+
+    start = STATS_START(stats);
+    for (i = 0; i < n; i++) {
+        sq = 0.0;
+        for (a = 0; a < size; a++) {
+            ny->B[i][a] /= sqrt(degree[i]);
+            sq += ny->B[i][a] * ny->B[i][a];
+        }
+        ny->row_norm[i] = sq;
+    }
+    STATS_STOP(stats, PHASE_NORMALIZE, start);
+
+    arena_release(&scratch);
+    return 0;
+}
+
+void nystrom_free(nystrom *ny){
+    free_matrix(ny->B, ny->n);
+    free(ny->row_norm);
+    ny->B = NULL;
+    ny->row_norm = NULL;
+}
+
+void nystrom_multiply(double **WH, const nystrom *ny, double **H, const int k, double **T){
+    int i, a, c;
+    double sum;
+
+    for (a = 0; a < ny->m; a++) {
+        for (c = 0; c < k; c++) {
+            T[a][c] = 0.0;
+        }
+    }
+    for (i = 0; i < ny->n; i++) {
+        for (a = 0; a < ny->m; a++) {
+            for (c = 0; c < k; c++) {
+                T[a][c] += ny->B[i][a] * H[i][c];
+            }
+        }
+    }
+    for (i = 0; i < ny->n; i++) {
+        for (c = 0; c < k; c++) {
+            sum = -ny->row_norm[i] * H[i][c];
+            for (a = 0; a < ny->m; a++) {
+                sum += ny->B[i][a] * T[a][c];
+            }
+            WH[i][c] = sum > 0.0 ? sum : 0.0;
+        }
+    }
+}
+
+int nystrom_squared_norm(double *squared_norm, const nystrom *ny){
+    int i, a, b;
+    double total = 0.0;
+    double **G = allocate_matrix(ny->m, ny->m);
+
+    if (G == NULL) {
+        return 1;
+    }
+    /* ||B B^T - diag(r)||^2 = ||B^T B||^2 - 2 sum r_i^2 + sum r_i^2 */
+    for (a = 0; a < ny->m; a++) {
+        for (b = 0; b < ny->m; b++) {
+            G[a][b] = 0.0;
+        }
+    }
+    for (i = 0; i < ny->n; i++) {
+        for (a = 0; a < ny->m; a++) {
+            for (b = 0; b < ny->m; b++) {
+                G[a][b] += ny->B[i][a] * ny->B[i][b];
+            }
+        }
+        total -= ny->row_norm[i] * ny->row_norm[i];
+    }
+    total += calc_frobenius_squared_norm(G, ny->m, ny->m);
+    free_matrix(G, ny->m);
+    *squared_norm = total > 0.0 ? total : 0.0;
+    return 0;
+}
+
+double nystrom_mean(const nystrom *ny){
+    int i, a;
+    double sum, total = 0.0;
+
+    /* 1^T (B B^T - diag(r)) 1 = ||B^T 1||^2 - sum r_i */
+    for (a = 0; a < ny->m; a++) {
+        sum = 0.0;
+        for (i = 0; i < ny->n; i++) {
+            sum += ny->B[i][a];
+        }
+        total += sum * sum;
+    }
+    for (i = 0; i < ny->n; i++) {
+        total -= ny->row_norm[i];
+    }
+    return total / ((double)ny->n * (double)ny->n);
+}
@@ -0,0 +1,74 @@
+#ifndef NYSTROM_H
+#define NYSTROM_H
+
+#include "mat_utils.h"
+#include "stats.h"
+
+/**
+ * @brief Low-rank Nystrom approximation of the normalized similarity matrix W.
+ *
+ * With C the n x m affinities between all points and m landmark points
+ * (the exp(-dist/2) kernel, 1 on the diagonal) and M = L L^T the m x m
+ * block between the landmarks, the kernel is approximated by
+ * C M^-1 C^T = (C L^-T)(C L^-T)^T. Zeroing its diagonal gives A, and
+ * normalizing by the degrees of that approximation gives
+ *
+ *     W ~ B B^T - diag(row_norm),   B = D^-1/2 C L^-T,   row_norm[i] = ||B_i||^2
+ *
+ * so W H = C (M^-1 (C^T H)) up to the degree scaling costs O(nmk) and W
+ * itself is never formed.
+ */
+typedef struct {
+    int n, m;
+    double **B;
+    double *row_norm;
+} nystrom;
+
+/**
+ * @brief Pick m landmarks uniformly at random (using rand()) and build the approximation.
+ *
+ * @param ny Approximation to fill, released with nystrom_free.
+ * @param X Input data matrix.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param m Number of landmarks, clamped to n. Larger m is more accurate and slower.
+ * @param stats Optional telemetry, may be NULL.
+ * @return 0 on success, 1 on failure.
+ */
+int nystrom_build(nystrom *ny, double **X, const int n, const int d, const int m, symnmf_stats *stats);
+
+/**
+ * @brief Free the matrices of an approximation. Does nothing for a zeroed struct.
+ */
+void nystrom_free(nystrom *ny);
+
+/**
+ * @brief Calculate WH with the approximated W.
+ *
+ * Entries are clamped at 0: the exact product is nonnegative, and a
+ * negative entry would flip the sign of H in the multiplicative update.
+ *
+ * @param WH Output n x k matrix.
+ * @param ny Approximation of W.
+ * @param H Matrix H.
+ * @param k Number of clusters.
+ * @param T Scratch m x k matrix, receives B^T H.
+ */
+void nystrom_multiply(double **WH, const nystrom *ny, double **H, const int k, double **T);
+
+/**
+ * @brief ||W||_F^2 of the approximated W, in O(nm^2).
+ *
+ * @param squared_norm Output squared norm, clamped at 0 since the expansion
+ *                     can round slightly below it.
+ * @param ny Approximation of W.
+ * @return 0 on success, 1 if memory could not be allocated.
+ */
+int nystrom_squared_norm(double *squared_norm, const nystrom *ny);
+
+/**
+ * @brief Mean of all entries of the approximated W, for initialize_H_from_mean.
+ */
+double nystrom_mean(const nystrom *ny);
+
+#endif
@@ -0,0 +1,160 @@
+#ifdef __linux__
+/* pthread_attr_setaffinity_np and cpu_set_t */
+#define _GNU_SOURCE
+#endif
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include "mat_utils.h"
+#include "parallel.h"
+
+#if defined(__linux__) && defined(CPU_SETSIZE)
+#define PARALLEL_CAN_PIN
+#endif
+
+/* Multiply-adds below which a product is not worth splitting across threads. */
+#define PARALLEL_MIN_WORK (1 << 20)
+
+typedef struct {
+    int begin, end, tid;
+    parallel_body body;
+    void *ctx;
+} parallel_chunk;
+
+typedef struct {
+    double **result, **mat1, **mat2;
+    int cols1, cols2;
+} multiply_ctx;
+
+static void *run_chunk(void *arg){
+    parallel_chunk *chunk = (parallel_chunk *)arg;
+    chunk->body(chunk->begin, chunk->end, chunk->tid, chunk->ctx);
+    return NULL;
+}
+
+int default_num_threads(void){
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+int resolve_num_threads(const int num_threads){
+    return num_threads > 0 ? num_threads : default_num_threads();
+}
+
+#ifdef PARALLEL_CAN_PIN
+/**
+ * @brief The slot-th CPU of allowed, wrapping around; allowed must not be empty.
+ */
+static int nth_cpu(const cpu_set_t *allowed, const int slot){
+    int c, seen = 0, target = slot % CPU_COUNT(allowed);
+    for (c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, allowed) && seen++ == target) {
+            return c;
+        }
+    }
+    return 0;
+}
+#endif
+
+/**
+ * @brief parallel_for, with every chunk started on a thread pinned to its own CPU if pinned is set.
+ */
+static void run_chunks(const int n, const int num_threads, parallel_body body, void *ctx, const int pinned){
+    int t, first = 1;
+    parallel_chunk *chunks;
+    pthread_t *threads;
+    int *started;
+#ifdef PARALLEL_CAN_PIN
+    cpu_set_t allowed, cpu;
+    pthread_attr_t attr;
+#endif
+
+    if (num_threads <= 1 || n <= 1) {
+        body(0, n, 0, ctx);
+        return;
+    }
+
+    chunks = (parallel_chunk *)malloc(num_threads * sizeof(parallel_chunk));
+    threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+    started = (int *)calloc(num_threads, sizeof(int));
+    if (chunks == NULL || threads == NULL || started == NULL) {
+        free(chunks);
+        free(threads);
+        free(started);
+        body(0, n, 0, ctx);
+        return;
+    }
+
+    for (t = 0; t < num_threads; t++) {
+        chunks[t].begin = (int)((double)n * t / num_threads);
+        chunks[t].end = (int)((double)n * (t + 1) / num_threads);
+        chunks[t].tid = t;
+        chunks[t].body = body;
+        chunks[t].ctx = ctx;
+    }
+#ifdef PARALLEL_CAN_PIN
+    /* the calling thread keeps its own affinity, so chunk 0 gets a thread too */
+    if (pinned && pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed) == 0
+        && CPU_COUNT(&allowed) > 0 && pthread_attr_init(&attr) == 0) {
+        for (t = 0; t < num_threads; t++) {
+            CPU_ZERO(&cpu);
+            CPU_SET(nth_cpu(&allowed, t), &cpu);
+            started[t] = pthread_attr_setaffinity_np(&attr, sizeof(cpu), &cpu) == 0
+                         && pthread_create(&threads[t], &attr, run_chunk, &chunks[t]) == 0;
+        }
+        pthread_attr_destroy(&attr);
+        first = 0;
+    }
+#else
+    (void)pinned;
+#endif
+    if (first == 1) {
+        for (t = 1; t < num_threads; t++) {
+            started[t] = pthread_create(&threads[t], NULL, run_chunk, &chunks[t]) == 0;
+        }
+        run_chunk(&chunks[0]);
+    }
+    for (t = first; t < num_threads; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            run_chunk(&chunks[t]);
+        }
+    }
+
+    free(chunks);
+    free(threads);
+    free(started);
+}
+
+void parallel_for(const int n, const int num_threads, parallel_body body, void *ctx){
+    run_chunks(n, num_threads, body, ctx, 0);
+}
+
+void parallel_for_pinned(const int n, const int num_threads, parallel_body body, void *ctx){
+    run_chunks(n, num_threads, body, ctx, 1);
+}
+
+static void multiply_rows(const int begin, const int end, const int tid, void *arg){
+    multiply_ctx *ctx = (multiply_ctx *)arg;
+    (void)tid;
+    /* rows are pointers, so a row range is a matrix of its own */
+    multiply_matrixes_into(ctx->result + begin, ctx->mat1 + begin, ctx->mat2, end - begin, ctx->cols1, ctx->cols2);
+}
+
+void parallel_multiply_into(double **result, double **mat1, double **mat2, const int rows1, const int cols1,
+                            const int cols2, const int num_threads){
+    multiply_ctx ctx;
+    if (num_threads <= 1 || (double)rows1 * cols1 * cols2 < PARALLEL_MIN_WORK) {
+        multiply_matrixes_into(result, mat1, mat2, rows1, cols1, cols2);
+        return;
+    }
+    ctx.result = result;
+    ctx.mat1 = mat1;
+    ctx.mat2 = mat2;
+    ctx.cols1 = cols1;
+    ctx.cols2 = cols2;
+    parallel_for_pinned(rows1, num_threads, multiply_rows, &ctx);
+}
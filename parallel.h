@@ -0,0 +1,73 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ * @brief Body of a parallel loop, run on the half-open range [begin, end).
+ *
+ * @param begin First index of the chunk.
+ * @param end One past the last index of the chunk.
+ * @param tid Index of the chunk, in [0, num_threads).
+ * @param ctx Opaque pointer given to parallel_for.
+ */
+typedef void (*parallel_body)(const int begin, const int end, const int tid, void *ctx);
+
+/**
+ * @brief Number of online CPUs, at least 1.
+ */
+int default_num_threads(void);
+
+/**
+ * @brief Resolve a requested thread count: values <= 0 mean default_num_threads().
+ */
+int resolve_num_threads(const int num_threads);
+
+/**
+ * @brief Split [0, n) into num_threads contiguous chunks and run body on each.
+ *
+ * Chunk t covers [t * n / num_threads, (t + 1) * n / num_threads), so the
+ * same thread count always yields the same partition. The calling thread
+ * runs chunk 0; if a thread cannot be started its chunk runs inline.
+ *
+ * @param n Number of iterations.
+ * @param num_threads Number of chunks, at least 1.
+ * @param body Function run on each chunk.
+ * @param ctx Opaque pointer handed to body.
+ */
+void parallel_for(const int n, const int num_threads, parallel_body body, void *ctx);
+
+/**
+ * @brief parallel_for with chunk t always run on the same CPU.
+ *
+ * Every chunk, chunk 0 included, runs on a new thread pinned to the t-th
+ * CPU (wrapping around) of those the calling thread may run on, and the
+ * calling thread only waits, keeping its own affinity. Two calls with the
+ * same n and num_threads thus run each chunk on the same CPU, and so on
+ * the same NUMA node. Where affinity is not supported this is parallel_for.
+ *
+ * @param n Number of iterations.
+ * @param num_threads Number of chunks, at least 1.
+ * @param body Function run on each chunk.
+ * @param ctx Opaque pointer handed to body.
+ */
+void parallel_for_pinned(const int n, const int num_threads, parallel_body body, void *ctx);
+
+/**
+ * @brief multiply_matrixes_into with the rows of the result split by parallel_for.
+ *
+ * Each row is computed exactly as multiply_matrixes_into computes it, so the
+ * result does not depend on num_threads. The chunks are pinned as by
+ * parallel_for_pinned. Products too small to amortize starting threads run
+ * on the calling thread.
+ *
+ * @param result Output rows1 x cols2 matrix, must not alias the inputs.
+ * @param mat1 First input matrix.
+ * @param mat2 Second input matrix.
+ * @param rows1 Number of rows in the first matrix.
+ * @param cols1 Number of columns in the first matrix.
+ * @param cols2 Number of columns in the second matrix.
+ * @param num_threads Number of threads, at least 1.
+ */
+void parallel_multiply_into(double **result, double **mat1, double **mat2, const int rows1, const int cols1,
+                            const int cols2, const int num_threads);
+
+#endif
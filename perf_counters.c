@@ -0,0 +1,138 @@
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include <unistd.h>
+#include "perf_counters.h"
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char *counter_names[PERF_COUNTER_COUNT] = {
+    "cycles",
+    "instructions",
+    "cache_misses",
+    "branch_misses"
+};
+
+const char *perf_counter_name(const int counter){
+    if (counter < 0 || counter >= PERF_COUNTER_COUNT) {
+        return "unknown";
+    }
+    return counter_names[counter];
+}
+
+#ifdef __linux__
+static const __u64 counter_configs[PERF_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+int perf_counters_open(perf_counters *pc){
+    struct perf_event_attr attr;
+    int i, opened = 0;
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = counter_configs[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        /* this thread on any CPU; there is no glibc wrapper for the call */
+        pc->fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        opened += pc->fds[i] >= 0;
+    }
+    return opened;
+}
+
+/**
+ * @brief Read the value, time enabled and time running of a counter.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int read_counter(const int fd, double *out){
+    __u64 buffer[3];
+    if (read(fd, buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer)) {
+        return 1;
+    }
+    out[0] = (double)buffer[0];
+    out[1] = (double)buffer[1];
+    out[2] = (double)buffer[2];
+    return 0;
+}
+
+/*
+ * PERF_EVENT_IOC_RESET does not clear what exited inherited threads added,
+ * so counts are taken as differences from the values at start.
+ */
+void perf_counters_start(perf_counters *pc){
+    int i;
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fds[i] >= 0 && read_counter(pc->fds[i], pc->start[i]) == 0) {
+            ioctl(pc->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void perf_counters_stop(perf_counters *pc, double *values){
+    double now[3];
+    int i;
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fds[i] >= 0) {
+            ioctl(pc->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        values[i] = -1.0;
+        if (pc->fds[i] < 0 || read_counter(pc->fds[i], now) != 0) {
+            continue;
+        }
+        values[i] = now[0] - pc->start[i][0];
+        if (now[2] > pc->start[i][2]) {
+            /* scale up for the time the kernel multiplexed the counter out */
+            values[i] *= (now[1] - pc->start[i][1]) / (now[2] - pc->start[i][2]);
+        }
+    }
+}
+
+void perf_counters_close(perf_counters *pc){
+    int i;
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fds[i] >= 0) {
+            close(pc->fds[i]);
+            pc->fds[i] = -1;
+        }
+    }
+}
+#else
+int perf_counters_open(perf_counters *pc){
+    int i;
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        pc->fds[i] = -1;
+    }
+    return 0;
+}
+
+void perf_counters_start(perf_counters *pc){
+    (void)pc;
+}
+
+void perf_counters_stop(perf_counters *pc, double *values){
+    int i;
+    (void)pc;
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        values[i] = -1.0;
+    }
+}
+
+void perf_counters_close(perf_counters *pc){
+    (void)pc;
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+enum PerfCounter{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+/**
+ * @brief Hardware counters of the calling thread and of the threads it starts.
+ *
+ * Each counter is opened on its own, so a CPU or hypervisor that lacks one
+ * event still reports the others. Counting is limited to user space, which
+ * needs no privileges under the default perf_event_paranoid setting.
+ */
+typedef struct {
+    int fds[PERF_COUNTER_COUNT];
+    /* value, time enabled and time running when counting started */
+    double start[PERF_COUNTER_COUNT][3];
+} perf_counters;
+
+/**
+ * @brief Open the counters, stopped.
+ *
+ * Threads started after this call are counted too, once they have been
+ * joined. On systems other than Linux no counter is available.
+ *
+ * @param pc Counters to open.
+ * @return Number of counters that could be opened.
+ */
+int perf_counters_open(perf_counters *pc);
+
+/**
+ * @brief Start counting.
+ */
+void perf_counters_start(perf_counters *pc);
+
+/**
+ * @brief Stop counting and read the counts since perf_counters_start.
+ *
+ * Counts are scaled up by enabled / running time when the kernel had to
+ * multiplex the counters.
+ *
+ * @param pc Counters to read.
+ * @param values Output PERF_COUNTER_COUNT counts, -1 for a counter that is not available.
+ */
+void perf_counters_stop(perf_counters *pc, double *values);
+
+/**
+ * @brief Close the counters.
+ */
+void perf_counters_close(perf_counters *pc);
+
+/**
+ * @brief Short lowercase name of a counter, e.g. "cache_misses".
+ */
+const char *perf_counter_name(const int counter);
+
+#endif
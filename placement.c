@@ -0,0 +1,272 @@
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include "placement.h"
+#include "parallel.h"
+
+/* Pages whose NUMA node is queried, spread evenly over the matrix. */
+#define PLACEMENT_SAMPLES 4096
+
+static int page_policy = PAGES_DEFAULT;
+static int owner_threads = 1;
+static int configured = 0;
+
+typedef struct {
+    double **mat;
+    int cols;
+    int *toucher_node;
+} touch_ctx;
+
+void placement_configure(const int pages, const int threads){
+    page_policy = pages;
+    owner_threads = resolve_num_threads(threads);
+    configured = 1;
+}
+
+int placement_threads(void){
+    return owner_threads;
+}
+
+int placement_parse_pages(const char *name){
+    if (strcmp(name, "default") == 0) {
+        return PAGES_DEFAULT;
+    }
+    if (strcmp(name, "thp") == 0) {
+        return PAGES_TRANSPARENT;
+    }
+    if (strcmp(name, "hugetlb") == 0) {
+        return PAGES_EXPLICIT;
+    }
+    return -1;
+}
+
+static const char *pages_name(const int pages){
+    switch (pages) {
+        case PAGES_TRANSPARENT:
+            return "thp";
+        case PAGES_EXPLICIT:
+            return "hugetlb";
+        default:
+            return "default";
+    }
+}
+
+static size_t round_up(size_t size, size_t unit){
+    return (size + unit - 1) / unit * unit;
+}
+
+static void release_mapping(void *block, size_t bytes){
+    munmap(block, bytes);
+}
+
+/**
+ * @brief Map bytes of anonymous memory backed by huge pages, as far as pages allows.
+ *
+ * @param used Output, the policy actually obtained.
+ * @param mapped Output, the size of the mapping.
+ * @return The mapping, NULL if only the default allocator is left.
+ */
+static void *map_huge(size_t bytes, const int pages, int *used, size_t *mapped){
+    size_t size = round_up(bytes, STATS_HUGE_PAGE), head;
+    char *raw, *aligned;
+
+#ifdef MAP_HUGETLB
+    if (pages == PAGES_EXPLICIT) {
+        raw = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (raw != (char *)MAP_FAILED) {
+            *used = PAGES_EXPLICIT;
+            *mapped = size;
+            return raw;
+        }
+    }
+#endif
+#ifdef MADV_HUGEPAGE
+    if (pages != PAGES_DEFAULT) {
+        /* over-map by one huge page and trim, so the start is huge page aligned */
+        raw = (char *)mmap(NULL, size + STATS_HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1, 0);
+        if (raw != (char *)MAP_FAILED) {
+            aligned = (char *)round_up((size_t)raw, STATS_HUGE_PAGE);
+            head = aligned - raw;
+            if (head > 0) {
+                munmap(raw, head);
+            }
+            munmap(aligned + size, STATS_HUGE_PAGE - head);
+            /* only advice: if refused, the mapping keeps regular pages */
+            madvise(aligned, size, MADV_HUGEPAGE);
+            *used = PAGES_TRANSPARENT;
+            *mapped = size;
+            return aligned;
+        }
+    }
+#endif
+#if !defined(MAP_HUGETLB) && !defined(MADV_HUGEPAGE)
+    (void)size;
+    (void)head;
+    (void)raw;
+    (void)aligned;
+    (void)pages;
+    (void)used;
+    (void)mapped;
+#endif
+    return NULL;
+}
+
+/**
+ * @brief NUMA node of the CPU the calling thread runs on, -1 if unknown.
+ */
+static int current_node(void){
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return (int)node;
+    }
+#endif
+    return -1;
+}
+
+static void touch_rows(const int begin, const int end, const int tid, void *arg){
+    touch_ctx *ctx = (touch_ctx *)arg;
+    if (end > begin) {
+        memset(ctx->mat[begin], 0, (size_t)(end - begin) * ctx->cols * sizeof(double));
+    }
+    ctx->toucher_node[tid] = current_node();
+}
+
+/**
+ * @brief Bytes of [start, start + bytes) backed by huge pages, from /proc/self/smaps.
+ *
+ * @param page_size Output, the kernel page size of the mapping.
+ * @return The byte count, 0 if smaps is not available.
+ */
+static long huge_backed_bytes(const char *start, const size_t bytes, long *page_size){
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    char line[512], perms[8];
+    unsigned long lo, hi, addr = (unsigned long)start, kb;
+    long huge = 0;
+    int inside = 0;
+
+    *page_size = sysconf(_SC_PAGESIZE);
+    if (smaps == NULL) {
+        return 0;
+    }
+    while (fgets(line, sizeof(line), smaps) != NULL) {
+        if (sscanf(line, "%lx-%lx %7s", &lo, &hi, perms) == 3) {
+            inside = lo < addr + bytes && hi > addr;
+        } else if (inside && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+            huge += (long)kb * 1024;
+        } else if (inside && sscanf(line, "KernelPageSize: %lu kB", &kb) == 1 && (long)kb * 1024 > *page_size) {
+            /* hugetlb mappings report their page size here rather than AnonHugePages */
+            *page_size = (long)kb * 1024;
+            huge = (long)bytes;
+        }
+    }
+    fclose(smaps);
+    return huge < (long)bytes ? huge : (long)bytes;
+}
+
+/**
+ * @brief Sample the NUMA node of the matrix pages and compare it to the node of their first toucher.
+ */
+static void sample_numa(stats_placement *p, double **mat, const int rows, const int cols, const int threads,
+                        const int *toucher_node){
+#if defined(__linux__) && defined(SYS_move_pages)
+    void *pages[PLACEMENT_SAMPLES];
+    int status[PLACEMENT_SAMPLES];
+    int i, t, row, count;
+    size_t data_bytes = (size_t)rows * cols * sizeof(double);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), step;
+
+    count = data_bytes / page < PLACEMENT_SAMPLES ? (int)(data_bytes / page) : PLACEMENT_SAMPLES;
+    if (count == 0) {
+        return;
+    }
+    step = data_bytes / count;
+    for (i = 0; i < count; i++) {
+        pages[i] = (char *)mat[0] + i * step;
+    }
+    /* with a NULL node list move_pages only reports where each page is */
+    if (syscall(SYS_move_pages, 0, (unsigned long)count, pages, NULL, status, 0) != 0) {
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        if (status[i] < 0) {
+            continue;
+        }
+        p->numa_sampled++;
+        p->numa_pages[status[i] < STATS_MAX_NODES ? status[i] : STATS_MAX_NODES - 1]++;
+        /* the chunk of the parallel_for partition holding this row */
+        row = (int)(i * step / (cols * sizeof(double)));
+        t = 0;
+        while (t + 1 < threads && row >= (int)((double)rows * (t + 1) / threads)) {
+            t++;
+        }
+        if (status[i] == toucher_node[t]) {
+            p->numa_local++;
+        }
+    }
+#else
+    (void)p;
+    (void)mat;
+    (void)rows;
+    (void)cols;
+    (void)threads;
+    (void)toucher_node;
+#endif
+}
+
+double **allocate_placed_matrix(const int rows, const int cols, symnmf_stats *stats){
+    size_t bytes = matrix_block_bytes(rows, cols), mapped = 0;
+    int used = PAGES_DEFAULT, threads = owner_threads, i;
+    void *block = NULL;
+    double **mat;
+    touch_ctx ctx;
+    stats_placement *p;
+
+    if (!configured || bytes < (size_t)STATS_HUGE_PAGE) {
+        mat = allocate_matrix(rows, cols);
+        if (mat != NULL) {
+            memset(mat[0], 0, (size_t)rows * cols * sizeof(double));
+        }
+        return mat;
+    }
+
+    block = map_huge(bytes, page_policy, &used, &mapped);
+    if (block != NULL) {
+        matrix_add_allocations(1);
+        mat = matrix_from_block(block, mapped, rows, cols, release_mapping);
+    } else {
+        mat = allocate_matrix(rows, cols);
+    }
+    ctx.toucher_node = (int *)malloc(threads * sizeof(int));
+    if (mat == NULL || ctx.toucher_node == NULL) {
+        free_matrix(mat, rows);
+        free(ctx.toucher_node);
+        return NULL;
+    }
+
+    ctx.mat = mat;
+    ctx.cols = cols;
+    parallel_for_pinned(rows, threads, touch_rows, &ctx);
+
+    if (stats != NULL) {
+        p = &stats->placement;
+        p->pages = pages_name(used);
+        p->threads = threads;
+        p->bytes = (long)bytes;
+        p->huge_bytes = huge_backed_bytes((char *)mat[0], (size_t)rows * cols * sizeof(double), &p->page_size);
+        p->numa_sampled = 0;
+        p->numa_local = 0;
+        for (i = 0; i < STATS_MAX_NODES; i++) {
+            p->numa_pages[i] = 0;
+        }
+        sample_numa(p, mat, rows, cols, threads, ctx.toucher_node);
+    }
+    free(ctx.toucher_node);
+    return mat;
+}
@@ -0,0 +1,61 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "mat_utils.h"
+#include "stats.h"
+
+enum PagePolicy{
+    PAGES_DEFAULT,
+    PAGES_TRANSPARENT,
+    PAGES_EXPLICIT
+};
+
+/**
+ * @brief Set how large matrices are allocated from now on.
+ *
+ * threads is both the number of threads that first-touch a placed matrix
+ * and the number of threads that later compute on its rows (sym, the
+ * products of norm and update_H). Both run through parallel_for_pinned, so
+ * each row block is computed on the CPU that placed its pages. The tiled
+ * graphs of tiles_configure balance their tiles by stealing and do not
+ * keep this pairing, and concurrent calls (e.g. jobs of a job pool) pin
+ * their chunks to the same CPUs. Until this is called, large matrices use
+ * allocate_matrix and a single thread.
+ *
+ * @param pages One of PagePolicy.
+ * @param threads Number of threads, <= 0 for one per online CPU.
+ */
+void placement_configure(const int pages, const int threads);
+
+/**
+ * @brief Number of threads owning the row blocks of large matrices, 1 by default.
+ */
+int placement_threads(void);
+
+/**
+ * @brief Parse "default", "thp" or "hugetlb".
+ *
+ * @return One of PagePolicy, -1 for an unknown name.
+ */
+int placement_parse_pages(const char *name);
+
+/**
+ * @brief Allocate a large matrix under the configured policy.
+ *
+ * With PAGES_TRANSPARENT the matrix is mapped on a huge page boundary and
+ * advised to use transparent huge pages. PAGES_EXPLICIT first tries the
+ * reserved huge page pool (MAP_HUGETLB). Either falls back to the next
+ * weaker policy, down to allocate_matrix. The rows are then zeroed by
+ * placement_threads() pinned threads so that each row block's pages are
+ * placed on the NUMA node of the CPU that computes it. Matrices smaller than a
+ * huge page skip all of this.
+ *
+ * @param rows Number of rows in the matrix.
+ * @param cols Number of columns in the matrix.
+ * @param stats Optional telemetry, may be NULL. Receives the page size,
+ *              huge page coverage and NUMA spread of the matrix.
+ * @return Zeroed matrix, freed with free_matrix. NULL on failure.
+ */
+double **allocate_placed_matrix(const int rows, const int cols, symnmf_stats *stats);
+
+#endif
@@ -0,0 +1,236 @@
+#include "quality.h"
+#include "parallel.h"
+
+/* Rows whose per-cluster distance sums are accumulated together. */
+#define SILHOUETTE_ROW_BLOCK 64
+/* Columns visited per tile, so their data points stay in cache across the row block. */
+#define SILHOUETTE_COL_TILE 256
+
+typedef struct {
+    double **X, **A;
+    int n, d, k;
+    const int *labels;
+    const int *sizes;
+    double *partial;
+    /* one flag per thread, reduced after the join */
+    int *failed;
+} silhouette_ctx;
+
+typedef struct {
+    double **W, **H;
+    int n, k;
+    double *trace;
+    double *wh;
+    double *gram;
+    double *w_squared;
+} objective_ctx;
+
+void assign_clusters(int *labels, double **H, const int n, const int k){
+    int i, j, best;
+    for (i = 0; i < n; i++) {
+        best = 0;
+        for (j = 1; j < k; j++) {
+            if (H[i][j] > H[i][best]) {
+                best = j;
+            }
+        }
+        labels[i] = best;
+    }
+}
+
+/**
+ * @brief Euclidean distance between points i and j, taken from A when possible.
+ */
+static double point_distance(const silhouette_ctx *ctx, const int i, const int j){
+    if (ctx->A != NULL && ctx->A[i][j] > 0.0) {
+        return sqrt(-2.0 * log(ctx->A[i][j]));
+    }
+    return sqrt(calc_squared_euclidean_distance(ctx->X[i], ctx->X[j], ctx->d));
+}
+
+/**
+ * @brief Silhouette coefficient of point i from its summed distance to every cluster.
+ */
+static double point_silhouette(const silhouette_ctx *ctx, const int i, const double *sums){
+    int c, own = ctx->labels[i];
+    double a, b = -1.0, mean;
+
+    if (ctx->sizes[own] <= 1) {
+        return 0.0;
+    }
+    a = sums[own] / (ctx->sizes[own] - 1);
+    for (c = 0; c < ctx->k; c++) {
+        if (c != own && ctx->sizes[c] > 0) {
+            mean = sums[c] / ctx->sizes[c];
+            if (b < 0.0 || mean < b) {
+                b = mean;
+            }
+        }
+    }
+    if (b < 0.0 || (a == 0.0 && b == 0.0)) {
+        return 0.0;
+    }
+    return (b - a) / (a > b ? a : b);
+}
+
+static void silhouette_rows(const int begin, const int end, const int tid, void *arg){
+    silhouette_ctx *ctx = (silhouette_ctx *)arg;
+    int i, j, i0, i1, j0, j1, k = ctx->k;
+    double total = 0.0;
+    double *sums = (double *)malloc((size_t)SILHOUETTE_ROW_BLOCK * k * sizeof(double));
+
+    if (sums == NULL) {
+        ctx->failed[tid] = 1;
+        return;
+    }
+    for (i0 = begin; i0 < end; i0 += SILHOUETTE_ROW_BLOCK) {
+        i1 = i0 + SILHOUETTE_ROW_BLOCK < end ? i0 + SILHOUETTE_ROW_BLOCK : end;
+        for (i = 0; i < (i1 - i0) * k; i++) {
+            sums[i] = 0.0;
+        }
+        for (j0 = 0; j0 < ctx->n; j0 += SILHOUETTE_COL_TILE) {
+            j1 = j0 + SILHOUETTE_COL_TILE < ctx->n ? j0 + SILHOUETTE_COL_TILE : ctx->n;
+            for (i = i0; i < i1; i++) {
+                for (j = j0; j < j1; j++) {
+                    if (i != j) {
+                        sums[(i - i0) * k + ctx->labels[j]] += point_distance(ctx, i, j);
+                    }
+                }
+            }
+        }
+        for (i = i0; i < i1; i++) {
+            total += point_silhouette(ctx, i, sums + (i - i0) * k);
+        }
+    }
+    ctx->partial[tid] = total;
+    free(sums);
+}
+
+int silhouette_score(double *score, double **X, const int n, const int d, const int *labels, const int k,
+                     double **A, const int num_threads){
+    int i, used = 0, threads = resolve_num_threads(num_threads);
+    int *sizes = (int *)calloc(k, sizeof(int));
+    double *partial = (double *)calloc(threads, sizeof(double));
+    int *failed = (int *)calloc(threads, sizeof(int));
+    double total = 0.0;
+    silhouette_ctx ctx;
+
+    if (sizes == NULL || partial == NULL || failed == NULL) {
+        free(sizes);
+        free(partial);
+        free(failed);
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        if (sizes[labels[i]]++ == 0) {
+            used++;
+        }
+    }
+    if (used < 2) {
+        free(sizes);
+        free(partial);
+        free(failed);
+        *score = 0.0;
+        return 0;
+    }
+
+    ctx.X = X;
+    ctx.A = A;
+    ctx.n = n;
+    ctx.d = d;
+    ctx.k = k;
+    ctx.labels = labels;
+    ctx.sizes = sizes;
+    ctx.partial = partial;
+    ctx.failed = failed;
+    parallel_for(n, threads, silhouette_rows, &ctx);
+
+    for (i = 0; i < threads; i++) {
+        total += partial[i];
+        used = used > 0 && failed[i] == 0;
+    }
+    free(sizes);
+    free(partial);
+    free(failed);
+    if (!used) {
+        return 1;
+    }
+    *score = total / n;
+    return 0;
+}
+
+static void objective_rows(const int begin, const int end, const int tid, void *arg){
+    objective_ctx *ctx = (objective_ctx *)arg;
+    int i, j, a, b, k = ctx->k;
+    double trace = 0.0, w_squared = 0.0;
+    double *wh = ctx->wh + (size_t)tid * k;
+    double *gram = ctx->gram + (size_t)tid * k * k;
+
+    for (i = begin; i < end; i++) {
+        /* row i of WH, dotted with row i of H */
+        for (a = 0; a < k; a++) {
+            wh[a] = 0.0;
+        }
+        for (j = 0; j < ctx->n; j++) {
+            w_squared += ctx->W[i][j] * ctx->W[i][j];
+            for (a = 0; a < k; a++) {
+                wh[a] += ctx->W[i][j] * ctx->H[j][a];
+            }
+        }
+        for (a = 0; a < k; a++) {
+            trace += wh[a] * ctx->H[i][a];
+        }
+        for (a = 0; a < k; a++) {
+            for (b = 0; b < k; b++) {
+                gram[a * k + b] += ctx->H[i][a] * ctx->H[i][b];
+            }
+        }
+    }
+    ctx->trace[tid] = trace;
+    ctx->w_squared[tid] = w_squared;
+}
+
+int symnmf_objective(double *objective, double **W, double **H, const int n, const int k, const int num_threads){
+    int t, c, threads = resolve_num_threads(num_threads);
+    double trace = 0.0, w_squared = 0.0, gram_squared = 0.0, entry;
+    objective_ctx ctx;
+
+    ctx.W = W;
+    ctx.H = H;
+    ctx.n = n;
+    ctx.k = k;
+    ctx.trace = (double *)calloc(threads, sizeof(double));
+    ctx.w_squared = (double *)calloc(threads, sizeof(double));
+    ctx.wh = (double *)calloc((size_t)threads * k, sizeof(double));
+    ctx.gram = (double *)calloc((size_t)threads * k * k, sizeof(double));
+    if (ctx.trace == NULL || ctx.w_squared == NULL || ctx.wh == NULL || ctx.gram == NULL) {
+        free(ctx.trace);
+        free(ctx.w_squared);
+        free(ctx.wh);
+        free(ctx.gram);
+        return 1;
+    }
+    parallel_for(n, threads, objective_rows, &ctx);
+
+    for (t = 0; t < threads; t++) {
+        trace += ctx.trace[t];
+        w_squared += ctx.w_squared[t];
+    }
+    for (c = 0; c < k * k; c++) {
+        entry = 0.0;
+        for (t = 0; t < threads; t++) {
+            entry += ctx.gram[(size_t)t * k * k + c];
+        }
+        gram_squared += entry * entry;
+    }
+    free(ctx.trace);
+    free(ctx.w_squared);
+    free(ctx.wh);
+    free(ctx.gram);
+    /* the expansion cancels large terms, so a perfect fit can round below 0 */
+    *objective = w_squared - 2.0 * trace + gram_squared;
+    if (*objective < 0.0) {
+        *objective = 0.0;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include "mat_utils.h"
+
+/**
+ * @brief Hard-assign every data point to the cluster with the largest entry in its row of H.
+ *
+ * Ties go to the lowest cluster index, as numpy.argmax does.
+ *
+ * @param labels Output array of n labels in [0, k).
+ * @param H Factorized matrix H.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ */
+void assign_clusters(int *labels, double **H, const int n, const int k);
+
+/**
+ * @brief Mean silhouette coefficient of a clustering, using Euclidean distance.
+ *
+ * Points in singleton clusters score 0, as in scikit-learn. The pairwise
+ * distances are computed in row blocks split across threads. When the
+ * similarity matrix A from sym() is given, each distance is recovered as
+ * sqrt(-2 ln A[i][j]) instead of being recomputed from X; entries that
+ * underflowed to 0 fall back to X.
+ *
+ * @param score Output mean silhouette coefficient in [-1, 1], 0 if fewer than 2 clusters are used.
+ * @param X Input data matrix.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param labels Cluster of every data point, in [0, k).
+ * @param k Number of clusters.
+ * @param A Symmetric similarity matrix of X, or NULL.
+ * @param num_threads Number of threads, <= 0 for one per online CPU.
+ * @return 0 on success, 1 if memory could not be allocated.
+ */
+int silhouette_score(double *score, double **X, const int n, const int d, const int *labels, const int k,
+                     double **A, const int num_threads);
+
+/**
+ * @brief SymNMF objective ||W - HH^T||_F^2, without forming HH^T.
+ *
+ * Evaluated as ||W||^2 - 2 tr(H^T W H) + ||H^T H||^2, which needs O(n^2 k)
+ * time and O(k^2) extra memory per thread.
+ *
+ * @param objective Output objective, clamped at 0 since the expansion can round slightly below it.
+ * @param W Normalized symmetric matrix.
+ * @param H Factorized matrix H.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param num_threads Number of threads, <= 0 for one per online CPU.
+ * @return 0 on success, 1 if memory could not be allocated.
+ */
+int symnmf_objective(double *objective, double **W, double **H, const int n, const int k, const int num_threads);
+
+#endif
@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <pthread.h>
+#include "scheduler.h"
+
+typedef struct {
+    task_body body;
+    void *ctx;
+    int arg;
+    int waiting;
+    int first_edge;
+} task;
+
+typedef struct {
+    int to;
+    int next;
+} task_edge;
+
+struct task_graph {
+    task *tasks;
+    int count, capacity;
+    task_edge *edges;
+    int edge_count, edge_capacity;
+};
+
+/**
+ * @brief Ready tasks of one worker: the owner works at bottom, thieves at top.
+ *
+ * Every task is pushed exactly once, so items never needs more slots than
+ * the graph has tasks.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int *items;
+    int top, bottom;
+} task_deque;
+
+typedef struct {
+    task_graph *graph;
+    task_deque *deques;
+    int workers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int remaining;
+    long generation;
+    long steals;
+} task_run;
+
+typedef struct {
+    task_run *run;
+    int id;
+} task_worker;
+
+task_graph *task_graph_create(const int capacity){
+    task_graph *graph = (task_graph *)malloc(sizeof(task_graph));
+    if (graph == NULL) {
+        return NULL;
+    }
+    graph->tasks = (task *)malloc((capacity > 0 ? capacity : 1) * sizeof(task));
+    graph->count = 0;
+    graph->capacity = capacity;
+    graph->edges = NULL;
+    graph->edge_count = 0;
+    graph->edge_capacity = 0;
+    if (graph->tasks == NULL) {
+        free(graph);
+        return NULL;
+    }
+    return graph;
+}
+
+int task_graph_add(task_graph *graph, task_body body, void *ctx, const int arg){
+    task *t;
+    if (graph->count >= graph->capacity) {
+        return -1;
+    }
+    t = &graph->tasks[graph->count];
+    t->body = body;
+    t->ctx = ctx;
+    t->arg = arg;
+    t->waiting = 0;
+    t->first_edge = -1;
+    return graph->count++;
+}
+
+int task_graph_depend(task_graph *graph, const int before, const int after){
+    task_edge *edges;
+    int capacity;
+
+    if (before < 0 || before >= graph->count || after < 0 || after >= graph->count) {
+        return 1;
+    }
+    if (graph->edge_count == graph->edge_capacity) {
+        capacity = graph->edge_capacity > 0 ? 2 * graph->edge_capacity : 64;
+        edges = (task_edge *)realloc(graph->edges, capacity * sizeof(task_edge));
+        if (edges == NULL) {
+            return 1;
+        }
+        graph->edges = edges;
+        graph->edge_capacity = capacity;
+    }
+    graph->edges[graph->edge_count].to = after;
+    graph->edges[graph->edge_count].next = graph->tasks[before].first_edge;
+    graph->tasks[before].first_edge = graph->edge_count++;
+    graph->tasks[after].waiting++;
+    return 0;
+}
+
+int task_graph_size(const task_graph *graph){
+    return graph->count;
+}
+
+void task_graph_free(task_graph *graph){
+    if (graph == NULL) {
+        return;
+    }
+    free(graph->tasks);
+    free(graph->edges);
+    free(graph);
+}
+
+static void deque_push(task_deque *deque, const int id){
+    pthread_mutex_lock(&deque->lock);
+    deque->items[deque->bottom++] = id;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static int deque_pop(task_deque *deque){
+    int id = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        id = deque->items[--deque->bottom];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return id;
+}
+
+static int deque_steal(task_deque *deque){
+    int id = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        id = deque->items[deque->top++];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return id;
+}
+
+/**
+ * @brief Take a task from the worker's own deque, or else steal one, trying the next workers in turn.
+ */
+static int find_task(task_run *run, const int worker, long *steals){
+    int v, id = deque_pop(&run->deques[worker]);
+    for (v = 1; id < 0 && v < run->workers; v++) {
+        id = deque_steal(&run->deques[(worker + v) % run->workers]);
+        *steals += id >= 0;
+    }
+    return id;
+}
+
+/**
+ * @brief Release the successors of a finished task onto the worker's deque.
+ */
+static void finish_task(task_run *run, const int worker, const int id){
+    task_graph *graph = run->graph;
+    int e, to, released = 0;
+
+    pthread_mutex_lock(&run->lock);
+    for (e = graph->tasks[id].first_edge; e >= 0; e = graph->edges[e].next) {
+        to = graph->edges[e].to;
+        if (--graph->tasks[to].waiting == 0) {
+            deque_push(&run->deques[worker], to);
+            released = 1;
+        }
+    }
+    run->remaining--;
+    if (released) {
+        run->generation++;
+    }
+    if (released || run->remaining == 0) {
+        pthread_cond_broadcast(&run->wake);
+    }
+    pthread_mutex_unlock(&run->lock);
+}
+
+static void *run_worker(void *arg){
+    task_worker *self = (task_worker *)arg;
+    task_run *run = self->run;
+    task *t;
+    long seen, steals = 0;
+    int id, done = 0;
+
+    while (!done) {
+        id = find_task(run, self->id, &steals);
+        if (id < 0) {
+            /* look again after noting the generation, so a release in between is not slept through */
+            pthread_mutex_lock(&run->lock);
+            seen = run->generation;
+            pthread_mutex_unlock(&run->lock);
+            id = find_task(run, self->id, &steals);
+        }
+        if (id >= 0) {
+            t = &run->graph->tasks[id];
+            t->body(t->ctx, t->arg, self->id);
+            finish_task(run, self->id, id);
+            continue;
+        }
+        pthread_mutex_lock(&run->lock);
+        while (run->generation == seen && run->remaining > 0) {
+            pthread_cond_wait(&run->wake, &run->lock);
+        }
+        done = run->remaining == 0;
+        pthread_mutex_unlock(&run->lock);
+    }
+
+    pthread_mutex_lock(&run->lock);
+    run->steals += steals;
+    pthread_mutex_unlock(&run->lock);
+    return NULL;
+}
+
+/**
+ * @brief Deal the tasks without predecessors to the deques in contiguous runs.
+ *
+ * Each run is pushed backwards, so its owner pops it in order while
+ * thieves take from its far end.
+ */
+static void deal_roots(task_run *run){
+    task_graph *graph = run->graph;
+    int i, w, roots = 0, seen = 0;
+
+    for (i = 0; i < graph->count; i++) {
+        roots += graph->tasks[i].waiting == 0;
+    }
+    for (i = graph->count - 1; i >= 0; i--) {
+        if (graph->tasks[i].waiting == 0) {
+            /* roots - 1 - seen is the index of this root in order of addition */
+            w = (int)((double)(roots - 1 - seen) * run->workers / roots);
+            deque_push(&run->deques[w], i);
+            seen++;
+        }
+    }
+}
+
+int task_graph_run(task_graph *graph, const int num_threads, long *steals){
+    int w, workers = num_threads > 1 ? num_threads : 1;
+    task_run run;
+    task_worker *selves;
+    pthread_t *threads;
+    int *started, *items;
+
+    if (graph->count == 0) {
+        if (steals != NULL) {
+            *steals = 0;
+        }
+        return 0;
+    }
+    run.deques = (task_deque *)malloc(workers * sizeof(task_deque));
+    selves = (task_worker *)malloc(workers * sizeof(task_worker));
+    threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    started = (int *)calloc(workers, sizeof(int));
+    items = (int *)malloc((size_t)workers * graph->count * sizeof(int));
+    if (run.deques == NULL || selves == NULL || threads == NULL || started == NULL || items == NULL) {
+        free(run.deques);
+        free(selves);
+        free(threads);
+        free(started);
+        free(items);
+        return 1;
+    }
+
+    run.graph = graph;
+    run.workers = workers;
+    run.remaining = graph->count;
+    run.generation = 0;
+    run.steals = 0;
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.wake, NULL);
+    for (w = 0; w < workers; w++) {
+        pthread_mutex_init(&run.deques[w].lock, NULL);
+        run.deques[w].items = items + (size_t)w * graph->count;
+        run.deques[w].top = 0;
+        run.deques[w].bottom = 0;
+        selves[w].run = &run;
+        selves[w].id = w;
+    }
+    deal_roots(&run);
+
+    for (w = 1; w < workers; w++) {
+        started[w] = pthread_create(&threads[w], NULL, run_worker, &selves[w]) == 0;
+    }
+    run_worker(&selves[0]);
+    for (w = 1; w < workers; w++) {
+        if (started[w]) {
+            pthread_join(threads[w], NULL);
+        }
+    }
+
+    if (steals != NULL) {
+        *steals = run.steals;
+    }
+    for (w = 0; w < workers; w++) {
+        pthread_mutex_destroy(&run.deques[w].lock);
+    }
+    pthread_mutex_destroy(&run.lock);
+    pthread_cond_destroy(&run.wake);
+    free(run.deques);
+    free(selves);
+    free(threads);
+    free(started);
+    free(items);
+    return 0;
+}
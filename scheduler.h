@@ -0,0 +1,68 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/**
+ * @brief Body of a task.
+ *
+ * @param ctx Opaque pointer given to task_graph_add.
+ * @param arg Integer given to task_graph_add, e.g. the index of a tile.
+ * @param worker Index of the thread running the task, in [0, num_threads).
+ */
+typedef void (*task_body)(void *ctx, const int arg, const int worker);
+
+/**
+ * @brief A set of tasks and the dependencies between them, run once by task_graph_run.
+ */
+typedef struct task_graph task_graph;
+
+/**
+ * @brief Create an empty graph.
+ *
+ * @param capacity Maximum number of tasks.
+ * @return The graph, NULL on failure.
+ */
+task_graph *task_graph_create(const int capacity);
+
+/**
+ * @brief Add a task to the graph.
+ *
+ * @return Id of the task, -1 if the graph is full.
+ */
+int task_graph_add(task_graph *graph, task_body body, void *ctx, const int arg);
+
+/**
+ * @brief Make task after wait for task before to finish.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int task_graph_depend(task_graph *graph, const int before, const int after);
+
+/**
+ * @brief Run every task of the graph and return once all of them finished.
+ *
+ * Each thread owns a deque of ready tasks. It pushes the tasks its own
+ * completions make ready and pops them back newest first, so a successor
+ * usually runs on the thread that produced its input. A thread whose deque
+ * is empty steals the oldest task of another thread. The tasks without
+ * predecessors are dealt to the deques in contiguous runs, in the order
+ * they were added. The calling thread is worker 0; if a thread cannot be
+ * started the others take over its deque.
+ *
+ * @param graph Graph to run; it must not contain a cycle.
+ * @param num_threads Number of threads, at least 1.
+ * @param steals Output number of stolen tasks, may be NULL.
+ * @return 0 on success, 1 on failure (no task was run).
+ */
+int task_graph_run(task_graph *graph, const int num_threads, long *steals);
+
+/**
+ * @brief Number of tasks in the graph.
+ */
+int task_graph_size(const task_graph *graph);
+
+/**
+ * @brief Free a graph. NULL is ignored.
+ */
+void task_graph_free(task_graph *graph);
+
+#endif
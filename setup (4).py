@@ -1,6 +1,10 @@
 from setuptools import Extension, setup
 
-module = Extension("symnmfmodule", sources=['mat_utils.c', 'symnmf.c'])
+module = Extension("symnmfmodule",
+                   sources=['symnmfmodule.c', 'mat_utils.c', 'symnmf.c', 'stats.c', 'arena.c', 'checkpoint.c',
+                            'quality.c', 'parallel.c', 'nystrom.c', 'placement.c', 'collective.c',
+                            'sharded.c', 'scheduler.c', 'tiles.c', 'job_pool.c'],
+                   extra_link_args=['-pthread'])
 setup(
     name='symnmfmodule',
     version='1.0',
@@ -0,0 +1,391 @@
+#define _POSIX_C_SOURCE 200112L
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "symnmf.h"
+#include "sharded.h"
+
+/* How often the parent checks whether a forked rank has exited. */
+#define SHARD_POLL_NSEC 10000000L
+
+typedef struct {
+    collective c;
+    double **X;
+    int n, d, k;
+    double **H;
+    int status;
+} shard_rank;
+
+typedef struct {
+    collective_region *region;
+    pid_t *pids;
+    int shards;
+    int status;
+} shard_monitor;
+
+/**
+ * @brief Fill rows of W with the normalized similarities of rows [begin, begin + rows) of X.
+ *
+ * The values match norm() bit for bit: the similarity is computed as in
+ * sym(), and the two products of norm() reduce to (q_i A_ij) q_j.
+ *
+ * @return 0 on success, 1 if one of these rows has a zero degree (the group
+ *         is then aborted) or the group was aborted.
+ */
+static int build_W_rows(collective *c, double **W, double **X, double **q, const int begin, const int rows,
+                        const int n, const int d, symnmf_stats *stats){
+    int i, j, status;
+    double start, sum;
+
+    start = STATS_START(stats);
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < n; j++) {
+            W[i][j] = begin + i != j ? exp(-calc_squared_euclidean_distance(X[begin + i], X[j], d) / 2.0) : 0.0;
+        }
+    }
+    STATS_STOP(stats, PHASE_SYM, start);
+
+    start = STATS_START(stats);
+    for (i = 0; i < rows; i++) {
+        sum = 0.0;
+        for (j = 0; j < n; j++) {
+            sum += W[i][j];
+        }
+        if (sum == 0) {
+            /* no inverse square root, as in norm(); the other ranks must not wait for this one */
+            STATS_STOP(stats, PHASE_DEGREE, start);
+            c->ops->abort(c);
+            return 1;
+        }
+        q[begin + i][0] = 1.0 / sqrt(sum);
+    }
+    STATS_STOP(stats, PHASE_DEGREE, start);
+
+    start = STATS_START(stats);
+    status = c->ops->allgather_rows(c, q, n, 1);
+    STATS_STOP(stats, PHASE_EXCHANGE, start);
+    if (status != 0) {
+        return 1;
+    }
+
+    start = STATS_START(stats);
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < n; j++) {
+            W[i][j] = (q[begin + i][0] * W[i][j]) * q[j][0];
+        }
+    }
+    STATS_STOP(stats, PHASE_NORMALIZE, start);
+    return 0;
+}
+
+int symnmf_shard_worker(collective *c, double **X_rows, const int n, const int d, const int k, double **H,
+                        symnmf_stats *stats){
+    int i, j, a, b, iter, begin, end, rows, failed;
+    double start, flag, sums[3];
+    double **X, **W, **q, **WH, **HHtH, **H_old, **G, **H_own;
+    symnmf_stats *s = c->rank == 0 ? stats : NULL;
+
+    collective_rows(n, c->size, c->rank, &begin, &end);
+    rows = end - begin;
+    H_own = H + begin;
+    X = allocate_matrix(n, d);
+    W = allocate_matrix(rows, n);
+    q = allocate_matrix(n, 1);
+    WH = allocate_matrix(rows, k);
+    HHtH = allocate_matrix(rows, k);
+    H_old = allocate_matrix(rows, k);
+    G = allocate_matrix(k, k);
+
+    /* every rank learns whether any rank is short of memory, so none is left waiting */
+    sums[0] = X == NULL || W == NULL || q == NULL || WH == NULL || HHtH == NULL || H_old == NULL || G == NULL;
+    if (c->ops->allreduce_sum(c, sums, 1) != 0 || sums[0] != 0.0) {
+        free_matrix(X, n);
+        free_matrix(W, rows);
+        free_matrix(q, n);
+        free_matrix(WH, rows);
+        free_matrix(HHtH, rows);
+        free_matrix(H_old, rows);
+        free_matrix(G, k);
+        return 1;
+    }
+
+    /* X is gathered once, since each row of W needs every data point */
+    start = STATS_START(s);
+    for (i = 0; i < rows; i++) {
+        memcpy(X[begin + i], X_rows[i], d * sizeof(double));
+    }
+    failed = c->ops->allgather_rows(c, X, n, d);
+    STATS_STOP(s, PHASE_EXCHANGE, start);
+    failed = failed || build_W_rows(c, W, X, q, begin, rows, n, d, s);
+    free_matrix(X, n);
+    free_matrix(q, n);
+
+    /* sum and squared norm of W, for initialize_H and the objective */
+    sums[0] = 0.0;
+    sums[1] = 0.0;
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < n; j++) {
+            sums[0] += W[i][j];
+            sums[1] += W[i][j] * W[i][j];
+        }
+    }
+    start = STATS_START(s);
+    failed = failed || c->ops->allreduce_sum(c, sums, 2);
+    if (c->rank == 0) {
+        initialize_H_from_mean(H, n, k, sums[0] / ((double)n * (double)n));
+    }
+    failed = failed || c->ops->broadcast(c, H[0], n * k, 0);
+    STATS_STOP(s, PHASE_EXCHANGE, start);
+    begin_iterations(s, sums[1]);
+
+    for (iter = 0; iter < MAX_ITER && !failed; iter++) {
+        start = STATS_START(s);
+        multiply_matrixes_into(WH, W, H, rows, n, k);
+        STATS_STOP(s, PHASE_WH, start);
+
+        start = STATS_START(s);
+        for (a = 0; a < k; a++) {
+            for (b = 0; b < k; b++) {
+                G[a][b] = 0.0;
+                for (i = 0; i < rows; i++) {
+                    G[a][b] += H_own[i][a] * H_own[i][b];
+                }
+            }
+        }
+        STATS_STOP(s, PHASE_HHT, start);
+
+        start = STATS_START(s);
+        failed = c->ops->allreduce_sum(c, G[0], k * k);
+        STATS_STOP(s, PHASE_EXCHANGE, start);
+        if (failed) {
+            break;
+        }
+
+        /* HH^T H as H (H^T H): only the k x k Gram matrix crosses ranks */
+        start = STATS_START(s);
+        multiply_matrixes_into(HHtH, H_own, G, rows, k, k);
+        STATS_STOP(s, PHASE_HHTH, start);
+
+        start = STATS_START(s);
+        sums[0] = 0.0;
+        sums[1] = 0.0;
+        for (i = 0; i < rows; i++) {
+            for (a = 0; a < k; a++) {
+                sums[0] += H_own[i][a] * WH[i][a];
+                sums[1] += H_own[i][a] * HHtH[i][a];
+            }
+        }
+        copy_matrix(H_old, H_own, rows, k);
+        apply_update(H_own, WH, HHtH, rows, k, NULL);
+        STATS_STOP(s, PHASE_UPDATE, start);
+
+        start = STATS_START(s);
+        sums[2] = 0.0;
+        for (i = 0; i < rows; i++) {
+            for (a = 0; a < k; a++) {
+                sums[2] += (H_own[i][a] - H_old[i][a]) * (H_own[i][a] - H_old[i][a]);
+            }
+        }
+        STATS_STOP(s, PHASE_CONVERGENCE, start);
+
+        start = STATS_START(s);
+        failed = c->ops->allreduce_sum(c, sums, 3) || c->ops->allgather_rows(c, H, n, k);
+        STATS_STOP(s, PHASE_EXCHANGE, start);
+        if (failed) {
+            break;
+        }
+
+        /* rank 0 alone runs the callback, so it decides for everyone */
+        if (s != NULL) {
+            s->objective[s->iterations] = s->w_squared_norm - 2.0 * sums[0] + sums[1];
+        }
+        flag = c->rank == 0 && end_iteration(s, iter, sums[2], sums[2] < EPS);
+        failed = c->ops->broadcast(c, &flag, 1, 0);
+        if (failed || sums[2] < EPS || flag != 0.0) {
+            break;
+        }
+    }
+
+    free_matrix(W, rows);
+    free_matrix(WH, rows);
+    free_matrix(HHtH, rows);
+    free_matrix(H_old, rows);
+    free_matrix(G, k);
+    return failed;
+}
+
+static void *run_rank(void *arg){
+    shard_rank *r = (shard_rank *)arg;
+    int begin, end;
+    collective_rows(r->n, r->c.size, r->c.rank, &begin, &end);
+    r->status = symnmf_shard_worker(&r->c, r->X + begin, r->n, r->d, r->k, r->H, NULL);
+    return NULL;
+}
+
+/**
+ * @brief Run ranks 1..shards-1 as threads with their own copy of H, and rank 0 on the caller.
+ */
+static int run_loopback(collective_region *region, double **X, const int n, const int d, const int k,
+                        const int shards, double **H, symnmf_stats *stats){
+    int r, started, status = 0;
+    shard_rank *ranks = (shard_rank *)calloc(shards, sizeof(shard_rank));
+    pthread_t *threads = (pthread_t *)malloc(shards * sizeof(pthread_t));
+    collective c;
+
+    for (r = 1; ranks != NULL && threads != NULL && r < shards; r++) {
+        ranks[r].H = allocate_matrix(n, k);
+        status |= ranks[r].H == NULL;
+    }
+    if (ranks == NULL || threads == NULL || status != 0) {
+        for (r = 1; ranks != NULL && r < shards; r++) {
+            free_matrix(ranks[r].H, n);
+        }
+        free(ranks);
+        free(threads);
+        return 1;
+    }
+
+    for (r = 1; r < shards; r++) {
+        collective_shared_attach(&ranks[r].c, region, r);
+        ranks[r].X = X;
+        ranks[r].n = n;
+        ranks[r].d = d;
+        ranks[r].k = k;
+        if (pthread_create(&threads[r], NULL, run_rank, &ranks[r]) != 0) {
+            /* the ranks already started would wait for this one forever */
+            collective_shared_abort(region);
+            break;
+        }
+    }
+    started = r;
+    collective_shared_attach(&c, region, 0);
+    status = started < shards || symnmf_shard_worker(&c, X, n, d, k, H, stats) != 0;
+    for (r = 1; r < shards; r++) {
+        if (r < started) {
+            pthread_join(threads[r], NULL);
+            status |= ranks[r].status;
+        }
+        free_matrix(ranks[r].H, n);
+    }
+    free(ranks);
+    free(threads);
+    return status;
+}
+
+/**
+ * @brief Reap ranks 1..shards-1, aborting the group as soon as one of them fails.
+ *
+ * A crashed rank never reaches the next barrier, so without this the
+ * others, the parent included, would wait for it forever.
+ */
+static void *watch_ranks(void *arg){
+    shard_monitor *m = (shard_monitor *)arg;
+    struct timespec slice;
+    int r, wstatus, left = m->shards - 1;
+    pid_t reaped;
+
+    slice.tv_sec = 0;
+    slice.tv_nsec = SHARD_POLL_NSEC;
+    while (left > 0) {
+        for (r = 1; r < m->shards; r++) {
+            if (m->pids[r] <= 0 || (reaped = waitpid(m->pids[r], &wstatus, WNOHANG)) == 0) {
+                continue;
+            }
+            if (reaped < 0 || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+                m->status = 1;
+                collective_shared_abort(m->region);
+            }
+            m->pids[r] = 0;
+            left--;
+        }
+        if (left > 0) {
+            nanosleep(&slice, NULL);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Fork ranks 1..shards-1 as processes, and run rank 0 on the caller.
+ */
+static int run_processes(collective_region *region, double **X, const int n, const int d, const int k,
+                         const int shards, double **H, symnmf_stats *stats){
+    int r, begin, end, status = 0;
+    pid_t *pids = (pid_t *)malloc(shards * sizeof(pid_t));
+    shard_monitor monitor;
+    pthread_t watcher;
+    collective c;
+
+    if (pids == NULL) {
+        return 1;
+    }
+    fflush(stdout);
+    for (r = 1; r < shards; r++) {
+        pids[r] = fork();
+        if (pids[r] == 0) {
+            /* the child works on its copy-on-write view of X and H */
+            collective_shared_attach(&c, region, r);
+            collective_rows(n, shards, r, &begin, &end);
+            _exit(symnmf_shard_worker(&c, X + begin, n, d, k, H, NULL));
+        }
+        if (pids[r] < 0) {
+            break;
+        }
+    }
+    monitor.region = region;
+    monitor.pids = pids;
+    monitor.shards = r;
+    monitor.status = 0;
+    if (r < shards || pthread_create(&watcher, NULL, watch_ranks, &monitor) != 0) {
+        while (--r >= 1) {
+            kill(pids[r], SIGKILL);
+            waitpid(pids[r], NULL, 0);
+        }
+        free(pids);
+        return 1;
+    }
+    collective_shared_attach(&c, region, 0);
+    status = symnmf_shard_worker(&c, X, n, d, k, H, stats);
+    if (status != 0) {
+        /* the other ranks may still be waiting for rank 0 */
+        collective_shared_abort(region);
+    }
+    pthread_join(watcher, NULL);
+    free(pids);
+    return status || monitor.status;
+}
+
+double **symnmf_sharded(double **X, const int n, const int d, const int k, const int shards, const int backend,
+                        symnmf_stats *stats){
+    size_t gather = (size_t)n * (d > k ? d : k), reduce = (size_t)shards * (k * k > 3 ? k * k : 3);
+    collective_region *region;
+    double **H;
+    int status;
+
+    if (shards < 1 || shards > n) {
+        return NULL;
+    }
+    region = collective_shared_create(shards, gather > reduce ? gather : reduce, backend == SHARD_PROCESSES);
+    H = allocate_matrix(n, k);
+    if (region == NULL || H == NULL) {
+        collective_shared_destroy(region);
+        free_matrix(H, n);
+        return NULL;
+    }
+
+    if (backend == SHARD_PROCESSES) {
+        status = run_processes(region, X, n, d, k, shards, H, stats);
+    } else {
+        status = run_loopback(region, X, n, d, k, shards, H, stats);
+    }
+    collective_shared_destroy(region);
+    if (status != 0) {
+        free_matrix(H, n);
+        return NULL;
+    }
+    return H;
+}
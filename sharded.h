@@ -0,0 +1,59 @@
+#ifndef SHARDED_H
+#define SHARDED_H
+
+#include "collective.h"
+#include "stats.h"
+
+enum ShardBackend{
+    SHARD_PROCESSES,
+    SHARD_LOOPBACK
+};
+
+/**
+ * @brief Run one rank of a sharded SymNMF.
+ *
+ * The rank owns the rows [begin, end) given by collective_rows of X, of
+ * W and of H, and only ever holds its (end - begin) x n block of W. Rows
+ * of X are gathered once to compute that block. Each iteration exchanges
+ * only the rows of H (allgather) and the k x k partial Gram matrices H^T H
+ * together with the convergence partial sums (allreduce). H is initialized
+ * by rank 0 with rand() and broadcast.
+ *
+ * @param c Collective connecting the ranks.
+ * @param X_rows The rows of X owned by this rank.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param k Number of clusters.
+ * @param H Output n x k matrix, all of it filled on every rank.
+ * @param stats Optional telemetry, may be NULL; only honored on rank 0. Time
+ *              spent in collective calls is charged to PHASE_EXCHANGE.
+ * @return 0 on success, 1 if any rank failed to allocate its memory or the group was aborted.
+ */
+int symnmf_shard_worker(collective *c, double **X_rows, const int n, const int d, const int k, double **H,
+                        symnmf_stats *stats);
+
+/**
+ * @brief Run SymNMF on X split across shards ranks on this machine.
+ *
+ * With SHARD_PROCESSES the ranks are forked processes talking through a
+ * shared mapping; with SHARD_LOOPBACK they are threads of this process
+ * using the same transport. The caller runs rank 0 in both cases.
+ *
+ * A forked rank that crashes or fails aborts the group, so the call fails
+ * instead of waiting for it. The forked ranks allocate memory, which is
+ * only safe if no other thread of the process may hold a lock at the time
+ * of the fork; a caller running threads of its own should use SHARD_LOOPBACK.
+ *
+ * @param X Input data matrix.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param k Number of clusters.
+ * @param shards Number of ranks, at least 1 and at most n.
+ * @param backend One of ShardBackend.
+ * @param stats Optional telemetry, may be NULL.
+ * @return Factorized matrix H, NULL on failure.
+ */
+double **symnmf_sharded(double **X, const int n, const int d, const int k, const int shards, const int backend,
+                        symnmf_stats *stats);
+
+#endif
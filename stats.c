@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
+#include "mat_utils.h"
+#include "stats.h"
+
+static const char *phase_names[PHASE_COUNT] = {
+    "read",
+    "sym",
+    "degree",
+    "normalize",
+    "wh",
+    "hht",
+    "hhth",
+    "update",
+    "convergence",
+    "exchange",
+    "tasks"
+};
+
+void stats_init(symnmf_stats *stats, stats_iter_callback callback, void *callback_data){
+    int i;
+    for (i = 0; i < PHASE_COUNT; i++) {
+        stats->phase_time[i] = 0.0;
+        stats->phase_calls[i] = 0;
+    }
+    for (i = 0; i < MAX_ITER; i++) {
+        stats->objective[i] = 0.0;
+        stats->delta[i] = 0.0;
+    }
+    stats->iterations = 0;
+    stats->converged = 0;
+    stats->interrupted = 0;
+    stats->w_squared_norm = 0.0;
+    stats->allocations = 0;
+    stats->allocation_base = matrix_allocation_count();
+    stats->tasks = 0;
+    stats->steals = 0;
+    stats->placement.pages = "default";
+    stats->placement.threads = 0;
+    stats->placement.bytes = 0;
+    stats->placement.page_size = 0;
+    stats->placement.huge_bytes = 0;
+    stats->placement.numa_sampled = 0;
+    stats->placement.numa_local = 0;
+    for (i = 0; i < STATS_MAX_NODES; i++) {
+        stats->placement.numa_pages[i] = 0;
+    }
+    stats->callback = callback;
+    stats->callback_data = callback_data;
+}
+
+void stats_finish(symnmf_stats *stats){
+    stats->allocations = matrix_allocation_count() - stats->allocation_base;
+}
+
+double stats_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void stats_add_phase(symnmf_stats *stats, const int phase, const double start){
+    stats->phase_time[phase] += stats_now() - start;
+    stats->phase_calls[phase]++;
+}
+
+const char *stats_phase_name(const int phase){
+    if (phase < 0 || phase >= PHASE_COUNT) {
+        return "unknown";
+    }
+    return phase_names[phase];
+}
+
+/**
+ * @brief Print the page size, huge page coverage and NUMA spread of the placed matrix.
+ */
+static void print_placement(FILE *out, const stats_placement *p){
+    int i;
+    double mib = 1024.0 * 1024.0;
+    long entries;
+
+    fprintf(out, "placement    %s pages, %.1f MiB first-touched by %d threads\n", p->pages, p->bytes / mib,
+            p->threads);
+    if (p->page_size > 0) {
+        /* TLB entries needed to map the whole matrix at once */
+        entries = p->huge_bytes / STATS_HUGE_PAGE + (p->bytes - p->huge_bytes + p->page_size - 1) / p->page_size;
+        fprintf(out, "tlb          %ld B pages, %.1f MiB on huge pages, %ld entries to map\n", p->page_size,
+                p->huge_bytes / mib, entries);
+    }
+    if (p->numa_sampled > 0) {
+        fprintf(out, "numa         %ld pages sampled, %.1f%% local to their first toucher,", p->numa_sampled,
+                100.0 * p->numa_local / p->numa_sampled);
+        for (i = 0; i < STATS_MAX_NODES; i++) {
+            if (p->numa_pages[i] > 0) {
+                fprintf(out, " node%d %ld", i, p->numa_pages[i]);
+            }
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void stats_print(FILE *out, const symnmf_stats *stats){
+    int i;
+    for (i = 0; i < PHASE_COUNT; i++) {
+        if (stats->phase_calls[i] > 0) {
+            fprintf(out, "%-12s %10.6fs %6d calls\n", stats_phase_name(i), stats->phase_time[i],
+                    stats->phase_calls[i]);
+        }
+    }
+    fprintf(out, "allocations  %ld\n", stats->allocations);
+    if (stats->tasks > 0) {
+        fprintf(out, "tasks        %ld run, %ld stolen\n", stats->tasks, stats->steals);
+    }
+    if (stats->placement.bytes > 0) {
+        print_placement(out, &stats->placement);
+    }
+    if (stats->iterations > 0) {
+        fprintf(out, "iterations   %d%s\n", stats->iterations,
+                stats->converged ? " (converged)" : (stats->interrupted ? " (interrupted)" : ""));
+        for (i = 0; i < stats->iterations; i++) {
+            fprintf(out, "iter %-4d objective %.6e delta %.6e\n", i, stats->objective[i], stats->delta[i]);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+/* Iteration cap of symnmf(), also the capacity of the per-iteration history. */
+#define MAX_ITER 300
+
+enum StatsPhase{
+    PHASE_READ,
+    PHASE_SYM,
+    PHASE_DEGREE,
+    PHASE_NORMALIZE,
+    PHASE_WH,
+    PHASE_HHT,
+    PHASE_HHTH,
+    PHASE_UPDATE,
+    PHASE_CONVERGENCE,
+    PHASE_EXCHANGE,
+    PHASE_TASKS,
+    PHASE_COUNT
+};
+
+/* Number of NUMA nodes reported separately; higher nodes share the last bucket. */
+#define STATS_MAX_NODES 8
+/* Size of a transparent huge page (x86-64 and most arm64 kernels). */
+#define STATS_HUGE_PAGE (2L * 1024 * 1024)
+
+/**
+ * @brief Where the pages of the last matrix from allocate_placed_matrix ended up.
+ *
+ * bytes is 0 when no placed matrix was allocated. The NUMA counts come
+ * from querying a sample of the pages after they were first touched.
+ */
+typedef struct {
+    const char *pages;
+    int threads;
+    long bytes;
+    long page_size;
+    long huge_bytes;
+    long numa_sampled;
+    long numa_local;
+    long numa_pages[STATS_MAX_NODES];
+} stats_placement;
+
+/**
+ * @brief Called once per symnmf() iteration.
+ *
+ * @param iter Iteration index, starting from 0.
+ * @param objective ||W - HH^T||_F^2 of H before this iteration's update.
+ * @param delta ||H_new - H_old||_F^2 of this iteration.
+ * @param user The callback_data pointer given in the stats struct.
+ * @return 0 to continue, anything else to stop iterating.
+ */
+typedef int (*stats_iter_callback)(int iter, double objective, double delta, void *user);
+
+/**
+ * @brief Telemetry gathered by one sym/ddg/norm/symnmf invocation.
+ *
+ * Every instrumented function takes a pointer to this struct and skips all
+ * bookkeeping when it is NULL.
+ */
+typedef struct {
+    double phase_time[PHASE_COUNT];
+    int phase_calls[PHASE_COUNT];
+    int iterations;
+    int converged;
+    int interrupted;
+    double objective[MAX_ITER];
+    double delta[MAX_ITER];
+    double w_squared_norm;
+    long allocations;
+    long allocation_base;
+    long tasks;
+    long steals;
+    stats_placement placement;
+    stats_iter_callback callback;
+    void *callback_data;
+} symnmf_stats;
+
+/* Start timing a phase; evaluates to 0 without touching the clock when disabled. */
+#define STATS_START(stats) ((stats) != NULL ? stats_now() : 0.0)
+
+/* Charge the time elapsed since start to phase. */
+#define STATS_STOP(stats, phase, start) \
+    do { \
+        if ((stats) != NULL) { \
+            stats_add_phase((stats), (phase), (start)); \
+        } \
+    } while (0)
+
+/**
+ * @brief Reset the stats and mark the start of allocation counting.
+ *
+ * @param stats Stats to reset.
+ * @param callback Optional per-iteration callback, may be NULL.
+ * @param callback_data Opaque pointer handed to the callback.
+ */
+void stats_init(symnmf_stats *stats, stats_iter_callback callback, void *callback_data);
+
+/**
+ * @brief Record the number of matrix allocations made since stats_init.
+ *
+ * Allocations are counted per thread, so stats_init and stats_finish must
+ * be called on the thread that runs the instrumented work.
+ *
+ * @param stats Stats to finalize.
+ */
+void stats_finish(symnmf_stats *stats);
+
+/**
+ * @brief Current value of the monotonic clock in seconds.
+ */
+double stats_now(void);
+
+/**
+ * @brief Add the time elapsed since start to a phase.
+ *
+ * @param stats Stats to update.
+ * @param phase One of StatsPhase.
+ * @param start Value returned by STATS_START.
+ */
+void stats_add_phase(symnmf_stats *stats, const int phase, const double start);
+
+/**
+ * @brief Short lowercase name of a phase, e.g. "normalize".
+ */
+const char *stats_phase_name(const int phase);
+
+/**
+ * @brief Print a human readable report of the stats.
+ *
+ * @param out Stream to write to.
+ * @param stats Stats to print.
+ */
+void stats_print(FILE *out, const symnmf_stats *stats);
+
+#endif
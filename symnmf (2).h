@@ -6,8 +6,20 @@
 #include <math.h>
 #include <string.h>
 #include "mat_utils.h"
+#include "stats.h"
+#include "arena.h"
+#include "checkpoint.h"
+#include "quality.h"
+#include "nystrom.h"
+#include "parallel.h"
+#include "placement.h"
+#include "sharded.h"
+#include "scheduler.h"
+#include "tiles.h"
 
 #define ERROR_MESSAGE "An Error Has Occurred"
+/* symnmf stops once ||H_new - H_old||_F^2 drops below this. */
+#define EPS 1e-4
 
 
 /**
@@ -16,9 +28,10 @@
  * @param X Input data matrix.
  * @param n Number of data points.
  * @param d Dimension of each data point.
+ * @param stats Optional telemetry, may be NULL.
  * @return Symmetric similarity matrix.
  */
-double **sym(double **X, const int n, const int d);
+double **sym(double **X, const int n, const int d, symnmf_stats *stats);
 
 
 /**
@@ -27,9 +40,10 @@ double **sym(double **X, const int n, const int d);
  * @param X Input data matrix.
  * @param n Number of data points.
  * @param d Dimension of each data point.
+ * @param stats Optional telemetry, may be NULL.
  * @return Diagonal degree matrix.
  */
-double **ddg(double **X, const int n, const int d);
+double **ddg(double **X, const int n, const int d, symnmf_stats *stats);
 
 /**
  * @brief Calculate the normalized symmetric matrix from input data.
@@ -37,9 +51,20 @@ double **ddg(double **X, const int n, const int d);
  * @param X Input data matrix.
  * @param n Number of data points.
  * @param d Dimension of each data point.
- * @return Normalized symmetric matrix.
+ * @param stats Optional telemetry, may be NULL.
+ * @return Normalized symmetric matrix, NULL on failure or if a degree is zero.
  */
-double **norm(double **X, const int n, const int d);
+double **norm(double **X, const int n, const int d, symnmf_stats *stats);
+
+/**
+ * @brief Calculate the normalized symmetric matrix from an already computed similarity matrix.
+ *
+ * @param A Symmetric similarity matrix, as returned by sym.
+ * @param n Number of data points.
+ * @param stats Optional telemetry, may be NULL.
+ * @return Normalized symmetric matrix, NULL on failure or if a degree is zero.
+ */
+double **norm_from_sym(double **A, const int n, symnmf_stats *stats);
 
 /**
  * @brief Perform the Symmetric Non-negative Matrix Factorization (SymNMF).
@@ -50,8 +75,139 @@ double **norm(double **X, const int n, const int d);
  * @param n Number of data points.
  * @param d Dimension of each data point.
  * @param k Number of clusters.
+ * @param stats Optional telemetry, may be NULL. Records per-phase timings,
+ *              the objective and delta of every iteration, and invokes
+ *              stats->callback after each iteration.
  * @return Factorized matrix H.
  */
-double** symnmf(double **H, double **W, const int n, const int k);
+double** symnmf(double **H, double **W, const int n, const int k, symnmf_stats *stats);
+
+/**
+ * @brief Perform SymNMF, persisting progress to a checkpoint.
+ *
+ * Iteration starts at cp->header->iteration, so calling this with H loaded
+ * by checkpoint_load_H continues a saved run exactly where it stopped. H is
+ * saved every interval iterations, when the run finishes, and when the
+ * stats callback stops it.
+ *
+ * @param H Initial matrix H, or the H loaded from cp when resuming.
+ * @param W Normalized symmetric matrix.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param cp Checkpoint created for this n and k, NULL to not checkpoint.
+ * @param interval Number of iterations between saves, at least 1.
+ * @param stats Optional telemetry, may be NULL.
+ * @return Factorized matrix H, NULL on failure (including a failed save).
+ */
+double** symnmf_checkpoint(double **H, double **W, const int n, const int k, checkpoint *cp, const int interval,
+                           symnmf_stats *stats);
+
+/**
+ * @brief Initialize H uniformly in [0, 2*sqrt(m/k)], m being the mean of W, using rand().
+ *
+ * @param H Output n x k matrix.
+ * @param W Normalized symmetric matrix.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ */
+void initialize_H(double **H, double **W, const int n, const int k);
+
+/**
+ * @brief Perform SymNMF with stochastic mini-batch updates.
+ *
+ * Every epoch visits the rows of H in a random order (drawn with rand()),
+ * batch_size rows at a time. A step updates only its rows, using the
+ * matching rows of W and the Gram matrix H^T H, which is kept current by
+ * subtracting and adding the outer products of the rows that changed. A
+ * step costs O(batch_size * n * k), so progress is visible long before a
+ * full pass. Convergence is checked once per epoch, with the same EPS
+ * and MAX_ITER (counted in epochs) as symnmf.
+ *
+ * With batch_size >= n every step is a full update, but HH^T H is
+ * evaluated as H (H^T H) rather than (H H^T) H, so the result agrees with
+ * symnmf only up to rounding (around 1e-16), not bit for bit.
+ *
+ * @param H Initial matrix H, updated in place.
+ * @param W Normalized symmetric matrix.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param batch_size Number of rows per step, at least 1; values >= n give one step per epoch.
+ * @param stats Optional telemetry, may be NULL. Each iteration is one epoch;
+ *              the objective is evaluated at the start of each epoch.
+ * @return Factorized matrix H, NULL on failure.
+ */
+double** symnmf_minibatch(double **H, double **W, const int n, const int k, const int batch_size,
+                          symnmf_stats *stats);
+
+/**
+ * @brief Initialize H uniformly in [0, 2*sqrt(mean/k)] using rand().
+ *
+ * @param H Output n x k matrix.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param mean Mean of all entries of W.
+ */
+void initialize_H_from_mean(double **H, const int n, const int k, const double mean);
+
+/**
+ * @brief Perform SymNMF against the Nystrom approximation of W.
+ *
+ * Uses the same update rule and stopping criterion as symnmf, with WH
+ * taken from the low-rank factors and HH^T H computed as H(H^T H), so
+ * memory and time per iteration are O(nmk + nk^2) instead of O(n^2 k).
+ *
+ * @param H Initial n x k matrix H, updated in place.
+ * @param ny Approximation of W from nystrom_build.
+ * @param k Number of clusters.
+ * @param stats Optional telemetry, may be NULL. The objective is measured
+ *              against the approximated W.
+ * @return Factorized matrix H, NULL on failure.
+ */
+double** symnmf_nystrom(double **H, const nystrom *ny, const int k, symnmf_stats *stats);
+
+/**
+ * @brief Apply the multiplicative update to H given WH and HHtH.
+ *
+ * @param H Matrix H, or a block of its rows.
+ * @param WH Product of W and H, for the same rows.
+ * @param HHtH Product of HH^T and H, for the same rows.
+ * @param n Number of rows to update.
+ * @param k Number of clusters.
+ * @param stats Optional telemetry, may be NULL. When given, the objective
+ *              of H before the update is stored at stats->objective[stats->iterations].
+ */
+void apply_update(double **H, double **WH, double **HHtH, const int n, const int k, symnmf_stats *stats);
+
+/**
+ * @brief Reset the per-run fields of the stats before the first iteration.
+ *
+ * @param stats Optional telemetry, may be NULL.
+ * @param w_squared_norm ||W||_F^2, used for the objective.
+ */
+void begin_iterations(symnmf_stats *stats, const double w_squared_norm);
+
+/**
+ * @brief Record a finished iteration in the stats and run the callback.
+ *
+ * @param stats Optional telemetry, may be NULL.
+ * @param iter Iteration index.
+ * @param f_norm_diff ||H_new - H_old||_F^2 of the iteration.
+ * @param done Nonzero if the iteration converged.
+ * @return Nonzero if the callback asked to stop.
+ */
+int end_iteration(symnmf_stats *stats, const int iter, const double f_norm_diff, const int done);
+
+/**
+ * @brief Update the matrix H using the SymNMF update rule.
+ *
+ * @param H Matrix H.
+ * @param W Normalized symmetric matrix.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param stats Optional telemetry, may be NULL. When given, the objective of
+ *              H before the update is stored at stats->objective[stats->iterations].
+ * @return 0 on success, 1 on failure.
+ */
+int update_H(double **H, double **W, const int n, const int k, symnmf_stats *stats);
 
 #endif
\ No newline at end of file
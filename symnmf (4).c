@@ -1,45 +1,87 @@
 #include "symnmf.h"
-#define EPS 1e-4
-#define MAX_ITER 300
 #define BETA 0.5
 
-double** sym(double **X, const int n, const int d){
+/**
+ * @brief Scratch matrices of one update_H step, reused across iterations.
+ */
+typedef struct {
+    double **Ht, **WH, **HHt, **HHtH;
+} update_scratch;
+
+typedef struct {
+    double **A, **X;
+    int n, d;
+} sym_ctx;
+
+/**
+ * @brief Rows [begin, end) of the similarity matrix, as a parallel_for body.
+ */
+void calc_sym_rows(const int begin, const int end, const int tid, void *arg){
+    sym_ctx *ctx = (sym_ctx *)arg;
     int i,j;
-    double **A = allocate_matrix(n, n);
     double dist;
+    (void)tid;
 
-    if (A == NULL) {
-        return NULL;
-    }
-
-    for (i = 0; i < n; i++) {
-        for (j = 0; j < n; j++) {
+    for (i = begin; i < end; i++) {
+        for (j = 0; j < ctx->n; j++) {
             if (i != j) {
-                dist = calc_squared_euclidean_distance(X[i], X[j], d);
-                A[i][j] = exp((-dist)/2.0);
+                dist = calc_squared_euclidean_distance(ctx->X[i], ctx->X[j], ctx->d);
+                ctx->A[i][j] = exp((-dist)/2.0);
             } else {
-                A[i][j] = 0.0;
+                ctx->A[i][j] = 0.0;
             }
         }
     }
+}
+
+/**
+ * @brief Fill A with the symmetric similarity matrix of X.
+ *
+ * @param A Output n x n matrix.
+ * @param X Input data matrix.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param stats Optional telemetry, may be NULL.
+ */
+void calc_sym(double **A, double **X, const int n, const int d, symnmf_stats *stats){
+    double start;
+    sym_ctx ctx;
+
+    if (tiles_size() > 0 && tiled_norm(A, X, NULL, NULL, n, d, stats) == 0) {
+        return;
+    }
+    start = STATS_START(stats);
+    ctx.A = A;
+    ctx.X = X;
+    ctx.n = n;
+    ctx.d = d;
+    /* rows split and pinned like allocate_placed_matrix's first touch */
+    parallel_for_pinned(n, placement_threads(), calc_sym_rows, &ctx);
+    STATS_STOP(stats, PHASE_SYM, start);
+}
+
+double** sym(double **X, const int n, const int d, symnmf_stats *stats){
+    double **A = allocate_placed_matrix(n, n, stats);
+    if (A == NULL) {
+        return NULL;
+    }
+    calc_sym(A, X, n, d, stats);
     return A;
 }
 
 /**
  * @brief Calculate the diagonal degree matrix.
  *
+ * @param D Output n x n diagonal degree matrix.
  * @param A Symmetric similarity matrix.
  * @param n Number of data points.
- * @return Diagonal degree matrix.
+ * @param stats Optional telemetry, may be NULL.
  */
-double** calc_diagonal_degree_mat(double**A, const int n){
+void calc_diagonal_degree_mat(double **D, double**A, const int n, symnmf_stats *stats){
     double sum;
     int i, j;
-    double **D = allocate_matrix(n, n);
-    if (D == NULL){
-        return NULL;
-    }
-    
+    double start = STATS_START(stats);
+
     for (i = 0; i < n; i++) {
         sum = 0.0;
         for (j = 0; j < n; j++) {
@@ -48,70 +90,186 @@ double** calc_diagonal_degree_mat(double**A, const int n){
         }
         D[i][i] = sum;
     }
-    return D;
+    STATS_STOP(stats, PHASE_DEGREE, start);
 }
 
 /**
  * @brief Calculate the normalized symmetric matrix.
  *
+ * @param W Output n x n normalized symmetric matrix.
  * @param A Symmetric similarity matrix.
  * @param D Diagonal degree matrix.
  * @param n Number of data points.
- * @return Normalized symmetric matrix.
+ * @param scratch Arena for the intermediate matrices.
+ * @param stats Optional telemetry, may be NULL.
+ * @return 0 on success, 1 on failure or if a degree is zero.
  */
-double** calc_normalized_sym(double **A, double**D, const int n){
-    double **Q, **temp, **W;
-    Q = calc_inverse_sqrt_diagonal(D, n);
-    if (Q == NULL){
-        return NULL;
-    }
-    temp = multiply_matrixes(Q, A, n, n, n);
-    if (temp == NULL){
-        free_matrix(Q, n);
-        return NULL;
+int calc_normalized_sym(double **W, double **A, double**D, const int n, arena *scratch, symnmf_stats *stats){
+    double start;
+    double **Q = arena_matrix(scratch, n, n);
+    double **temp = arena_matrix(scratch, n, n);
+    if (Q == NULL || temp == NULL){
+        return 1;
     }
-    W = multiply_matrixes(temp, Q, n, n, n);
-    if (W == NULL){
-        free_matrix(Q, n);
-        free_matrix(temp, n);
-        return NULL;
+
+    start = STATS_START(stats);
+    if (calc_inverse_sqrt_diagonal_into(Q, D, n) != 0) {
+        STATS_STOP(stats, PHASE_NORMALIZE, start);
+        return 1;
     }
+    parallel_multiply_into(temp, Q, A, n, n, n, placement_threads());
+    parallel_multiply_into(W, temp, Q, n, n, n, placement_threads());
+    STATS_STOP(stats, PHASE_NORMALIZE, start);
+    return 0;
+}
 
-    free_matrix(Q, n);
-    free_matrix(temp, n);
-    return W;
+/**
+ * @brief Run ddg (D given) or norm (W given) as one tiled_norm graph.
+ *
+ * @param A n x n similarity matrix; filled from X, or read if X is NULL.
+ * @param X Input data matrix, NULL if A is already computed.
+ * @param D Output n x n diagonal degree matrix, may be NULL.
+ * @param W Output n x n normalized symmetric matrix, may be NULL.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param stats Optional telemetry, may be NULL.
+ * @return 0 on success, TILES_ZERO_DEGREE if W is given and a degree is zero,
+ *         1 if tiling is off or the graph could not be run.
+ */
+int calc_tiled_norm(double **A, double **X, double **D, double **W, const int n, const int d,
+                    symnmf_stats *stats){
+    int i, j, status;
+    double *degree;
+
+    if (tiles_size() <= 0) {
+        return 1;
+    }
+    degree = (double *)malloc(n * sizeof(double));
+    status = degree != NULL ? tiled_norm(A, X, degree, W, n, d, stats) : 1;
+    if (status != 0) {
+        free(degree);
+        return status;
+    }
+    for (i = 0; D != NULL && i < n; i++) {
+        for (j = 0; j < n; j++) {
+            D[i][j] = 0.0;
+        }
+        D[i][i] = degree[i];
+    }
+    free(degree);
+    return 0;
 }
 
-double** ddg(double **X, const int n, const int d){
-    double **D;
-    double **A = sym(X, n, d);
-    if (A==NULL){
+double** ddg(double **X, const int n, const int d, symnmf_stats *stats){
+    arena scratch;
+    double **A, **D;
+
+    arena_init(&scratch, arena_matrix_bytes(n, n));
+    A = arena_matrix(&scratch, n, n);
+    D = allocate_matrix(n, n);
+    if (A == NULL || D == NULL){
+        free_matrix(D, n);
+        arena_release(&scratch);
         return NULL;
     }
-    D = calc_diagonal_degree_mat(A, n);
-    free_matrix(A, n);
+
+    if (calc_tiled_norm(A, X, D, NULL, n, d, stats) != 0) {
+        calc_sym(A, X, n, d, stats);
+        calc_diagonal_degree_mat(D, A, n, stats);
+    }
+    arena_release(&scratch);
     return D;
 }
 
-double** norm(double **X, const int n, const int d){
-    double **A, **D, **W;
-    A = sym(X, n, d);
-    if (A==NULL){
+double** norm_from_sym(double **A, const int n, symnmf_stats *stats){
+    arena scratch;
+    double **D, **W;
+    int status;
+
+    W = allocate_placed_matrix(n, n, stats);
+    status = W != NULL ? calc_tiled_norm(A, NULL, NULL, W, n, 0, stats) : 1;
+    if (status == 0) {
+        return W;
+    }
+    if (status == TILES_ZERO_DEGREE) {
+        free_matrix(W, n);
         return NULL;
     }
 
-    D = calc_diagonal_degree_mat(A, n);
-    if (D==NULL){
-        free_matrix(A, n);
+    /* D and the two products inside calc_normalized_sym */
+    arena_init(&scratch, 3 * arena_matrix_bytes(n, n));
+    D = arena_matrix(&scratch, n, n);
+    if (D == NULL || W == NULL){
+        free_matrix(W, n);
+        arena_release(&scratch);
         return NULL;
     }
 
-    W = calc_normalized_sym(A, D, n);
-    free_matrix(A, n);
-    free_matrix(D, n);
+    calc_diagonal_degree_mat(D, A, n, stats);
+    if (calc_normalized_sym(W, A, D, n, &scratch, stats) != 0){
+        free_matrix(W, n);
+        W = NULL;
+    }
+    arena_release(&scratch);
+    return W;
+}
+
+double** norm(double **X, const int n, const int d, symnmf_stats *stats){
+    arena scratch;
+    double **A, **W;
+    int status;
+
+    arena_init(&scratch, arena_matrix_bytes(n, n));
+    A = arena_matrix(&scratch, n, n);
+    if (A == NULL){
+        arena_release(&scratch);
+        return NULL;
+    }
+
+    if (tiles_size() > 0) {
+        /* affinity, degree and normalize tiles in one graph */
+        W = allocate_placed_matrix(n, n, stats);
+        status = W != NULL ? calc_tiled_norm(A, X, NULL, W, n, d, stats) : 1;
+        if (status == 0) {
+            arena_release(&scratch);
+            return W;
+        }
+        free_matrix(W, n);
+        if (status == TILES_ZERO_DEGREE) {
+            arena_release(&scratch);
+            return NULL;
+        }
+    }
+    calc_sym(A, X, n, d, stats);
+    W = norm_from_sym(A, n, stats);
+    arena_release(&scratch);
     return W;
 }
 
+/**
+ * @brief Carve the scratch matrices of update_H out of an arena.
+ *
+ * @param s Scratch to fill.
+ * @param scratch Arena to allocate from.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @return 0 on success, 1 on failure.
+ */
+int alloc_update_scratch(update_scratch *s, arena *scratch, const int n, const int k){
+    s->Ht = arena_matrix(scratch, k, n);
+    s->WH = arena_matrix(scratch, n, k);
+    s->HHt = arena_matrix(scratch, n, n);
+    s->HHtH = arena_matrix(scratch, n, k);
+    return s->Ht == NULL || s->WH == NULL || s->HHt == NULL || s->HHtH == NULL;
+}
+
+/**
+ * @brief Number of arena bytes alloc_update_scratch needs.
+ */
+size_t update_scratch_bytes(const int n, const int k){
+    return arena_matrix_bytes(k, n) + 2 * arena_matrix_bytes(n, k) + arena_matrix_bytes(n, n);
+}
+
 /**
  * @brief Calculate WH and HHtH matrices for the update rule.
  *
@@ -119,122 +277,620 @@ double** norm(double **X, const int n, const int d){
  * @param W Normalized symmetric matrix.
  * @param n Number of data points.
  * @param k Number of clusters.
- * @param WH_out Output WH matrix.
- * @param HHtH_out Output HHtH matrix.
- * @return 0 on success, 1 on failure.
+ * @param s Scratch receiving WH and HHtH.
+ * @param stats Optional telemetry, may be NULL.
  */
-int calc_WH_HHth(double **H, double **W, const int n, const int k, double ***WH_out, double ***HHtH_out){
-    double **WH, **HHtH, **Ht, **HHt;
+void calc_WH_HHth(double **H, double **W, const int n, const int k, update_scratch *s, symnmf_stats *stats){
+    double start;
 
-    Ht = calc_transpose(H, n, k);
-    if (Ht == NULL){
-        return 1;
+    if (tiles_size() > 0) {
+        start = STATS_START(stats);
+        calc_transpose_into(s->Ht, H, n, k);
+        STATS_STOP(stats, PHASE_HHT, start);
+        if (tiled_update_products(s->WH, s->HHt, s->HHtH, W, H, s->Ht, n, k, stats) == 0) {
+            return;
+        }
     }
 
-    WH = multiply_matrixes(W, H, n, n, k);
-    if (WH == NULL){
-        free_matrix(Ht, k);
-        return 1;
-    }
+    start = STATS_START(stats);
+    parallel_multiply_into(s->WH, W, H, n, n, k, placement_threads());
+    STATS_STOP(stats, PHASE_WH, start);
 
-    HHt = multiply_matrixes(H, Ht, n, k, n);
-    if (HHt == NULL){
-        free_matrix(Ht, k);
-        free_matrix(WH, n);
-        return 1;
-    }
+    start = STATS_START(stats);
+    calc_transpose_into(s->Ht, H, n, k);
+    parallel_multiply_into(s->HHt, H, s->Ht, n, k, n, placement_threads());
+    STATS_STOP(stats, PHASE_HHT, start);
 
-    HHtH = multiply_matrixes(HHt, H, n, n, k);
-    if (HHtH == NULL){
-        free_matrix(Ht, k);
-        free_matrix(WH, n);
-        free_matrix(HHt, n);
-        return 1;
+    start = STATS_START(stats);
+    parallel_multiply_into(s->HHtH, s->HHt, H, n, n, k, placement_threads());
+    STATS_STOP(stats, PHASE_HHTH, start);
+}
+
+void apply_update(double **H, double **WH, double **HHtH, const int n, const int k, symnmf_stats *stats){
+    double start, trace_HtWH = 0.0, trace_HtHHtH = 0.0;
+    int i, j;
+
+    start = STATS_START(stats);
+    if (stats != NULL) {
+        /* ||W - HH^T||^2 = ||W||^2 - 2 tr(H^T W H) + tr(H^T HH^T H) */
+        for (i = 0; i < n; i++){
+            for(j = 0; j < k; j++){
+                trace_HtWH += H[i][j] * WH[i][j];
+                trace_HtHHtH += H[i][j] * HHtH[i][j];
+            }
+        }
+        stats->objective[stats->iterations] = stats->w_squared_norm - 2.0 * trace_HtWH + trace_HtHHtH;
     }
-    
-    free_matrix(HHt, n);
-    free_matrix(Ht, k);
 
-    *WH_out = WH;
-    *HHtH_out = HHtH;
-    return 0;
+    for (i = 0; i < n; i++){
+        for(j = 0; j < k; j++){
+            /*TODO: check if we need to handle the case where HHtH[i][j]=0 */
+            H[i][j] = H[i][j] * (1-BETA + BETA * (WH[i][j] / HHtH[i][j]));
+        }
+    }
+    STATS_STOP(stats, PHASE_UPDATE, start);
 }
 
-
 /**
- * @brief Update the matrix H using the SymNMF update rule.
+ * @brief Apply one SymNMF update to H using preallocated scratch.
  *
  * @param H Matrix H.
  * @param W Normalized symmetric matrix.
  * @param n Number of data points.
  * @param k Number of clusters.
- * @return 0 on success, 1 on failure.
+ * @param s Scratch from alloc_update_scratch.
+ * @param stats Optional telemetry, may be NULL.
  */
-int update_H(double **H, double **W, const int n, const int k){
-    double **WH, **HHtH;
-    int i, j;
+void update_H_scratch(double **H, double **W, const int n, const int k, update_scratch *s,
+                      symnmf_stats *stats){
+    calc_WH_HHth(H, W, n, k, s, stats);
+    apply_update(H, s->WH, s->HHtH, n, k, stats);
+}
 
-    if (calc_WH_HHth(H, W, n, k, &WH, &HHtH) != 0) {
+int update_H(double **H, double **W, const int n, const int k, symnmf_stats *stats){
+    arena scratch;
+    update_scratch s;
+
+    arena_init(&scratch, update_scratch_bytes(n, k));
+    if (alloc_update_scratch(&s, &scratch, n, k) != 0) {
+        arena_release(&scratch);
         return 1;
     }
+    update_H_scratch(H, W, n, k, &s, stats);
+    arena_release(&scratch);
+    return 0; 
+}
 
-    for (i = 0; i < n; i++){
-        for(j = 0; j < k; j++){
-            /*TODO: check if we need to handle the case where HHtH[i][j]=0 */
-            H[i][j] = H[i][j] * (1-BETA + BETA * (WH[i][j] / HHtH[i][j]));
+
+void initialize_H(double **H, double **W, const int n, const int k){
+    int i, j;
+    double m = 0.0;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            m += W[i][j];
         }
     }
+    initialize_H_from_mean(H, n, k, m / ((double)n * (double)n));
+}
 
-    free_matrix(WH, n);
-    free_matrix(HHtH, n);
-    return 0; 
+void initialize_H_from_mean(double **H, const int n, const int k, const double mean){
+    int i, j;
+    double upper = 2.0 * sqrt(mean / k);
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < k; j++) {
+            H[i][j] = upper * ((double)rand() / ((double)RAND_MAX + 1.0));
+        }
+    }
 }
 
+void begin_iterations(symnmf_stats *stats, const double w_squared_norm){
+    if (stats != NULL) {
+        stats->w_squared_norm = w_squared_norm;
+        stats->iterations = 0;
+        stats->converged = 0;
+        stats->interrupted = 0;
+    }
+}
 
-double** symnmf(double **H, double **W, const int n, const int k){
-    int iter;
-    double f_norm_diff;
+int end_iteration(symnmf_stats *stats, const int iter, const double f_norm_diff, const int done){
+    if (stats == NULL) {
+        return 0;
+    }
+    stats->delta[stats->iterations++] = f_norm_diff;
+    stats->converged = done;
+    if (stats->callback != NULL
+        && stats->callback(iter, stats->objective[stats->iterations - 1], f_norm_diff,
+                           stats->callback_data) != 0) {
+        stats->interrupted = 1;
+    }
+    return stats->interrupted;
+}
+
+double** symnmf_checkpoint(double **H, double **W, const int n, const int k, checkpoint *cp, const int interval,
+                           symnmf_stats *stats){
+    int iter, first_iter = 0, done = 0, interrupted;
+    double f_norm_diff, start;
+    double delta[MAX_ITER];
     double **H_old, **H_diff;
+    arena scratch;
+    update_scratch s;
 
-    H_old = allocate_matrix(n, k);
-    if (H_old == NULL){
-        return NULL;
+    if (cp != NULL) {
+        if (cp->header->finished) {
+            return H;
+        }
+        first_iter = cp->header->iteration;
+        memcpy(delta, cp->header->delta, first_iter * sizeof(double));
     }
 
-    H_diff = allocate_matrix(n, k); 
-    if (H_diff == NULL){
-        free_matrix(H_old, n);
+    arena_init(&scratch, update_scratch_bytes(n, k) + 2 * arena_matrix_bytes(n, k));
+    H_old = arena_matrix(&scratch, n, k);
+    H_diff = arena_matrix(&scratch, n, k);
+    if (H_old == NULL || H_diff == NULL || alloc_update_scratch(&s, &scratch, n, k) != 0){
+        arena_release(&scratch);
         return NULL;
     }
 
-    for (iter = 0; iter < MAX_ITER; iter++){
-        printf("ITER = %d\n", iter);
+    begin_iterations(stats, stats != NULL ? calc_frobenius_squared_norm(W, n, n) : 0.0);
+
+    for (iter = first_iter; iter < MAX_ITER && !done; iter++){
         copy_matrix(H_old, H, n, k);
-        if (update_H(H, W, n, k) != 0){
-            free_matrix(H_old, n);
-            free_matrix(H_diff, n);
+        update_H_scratch(H, W, n, k, &s, stats);
+        start = STATS_START(stats);
+        calc_mat_difference(H_diff, H, H_old, n, k);
+        f_norm_diff = calc_frobenius_squared_norm(H_diff, n, k);
+        STATS_STOP(stats, PHASE_CONVERGENCE, start);
+        delta[iter] = f_norm_diff;
+        done = f_norm_diff < EPS;
+        interrupted = end_iteration(stats, iter, f_norm_diff, done);
+        if (cp != NULL && (done || iter + 1 == MAX_ITER || interrupted || (iter + 1) % interval == 0)
+            && checkpoint_save(cp, H, iter + 1, delta, done || iter + 1 == MAX_ITER) != 0) {
+            arena_release(&scratch);
             return NULL;
         }
+        if (interrupted) {
+            break;
+        }
+    }
+    
+    arena_release(&scratch);
+    return H;
+}
+
+double** symnmf(double **H, double **W, const int n, const int k, symnmf_stats *stats){
+    return symnmf_checkpoint(H, W, n, k, NULL, 0, stats);
+}
+
+/**
+ * @brief Add sign * r^T r to the k x k matrix G for each of the given rows r.
+ */
+void add_outer_products(double **G, double **rows, const int count, const int k, const double sign){
+    int i, a, b;
+    for (i = 0; i < count; i++) {
+        for (a = 0; a < k; a++) {
+            for (b = 0; b < k; b++) {
+                G[a][b] += sign * rows[i][a] * rows[i][b];
+            }
+        }
+    }
+}
+
+double** symnmf_minibatch(double **H, double **W, const int n, const int k, const int batch_size,
+                          symnmf_stats *stats){
+    int epoch, b0, b, i, j, tmp, done = 0, batch = batch_size < n ? batch_size : n;
+    int *perm;
+    double f_norm_diff, start;
+    double **H_epoch, **H_diff, **G, **WH, **HHtH, **H_batch, **W_rows, **H_rows;
+    arena scratch;
+
+    if (batch <= 0) {
+        return NULL;
+    }
+    arena_init(&scratch, 2 * arena_matrix_bytes(n, k) + arena_matrix_bytes(k, k) + 3 * arena_matrix_bytes(batch, k)
+                         + 2 * (size_t)batch * sizeof(double *) + (size_t)n * sizeof(int));
+    H_epoch = arena_matrix(&scratch, n, k);
+    H_diff = arena_matrix(&scratch, n, k);
+    G = arena_matrix(&scratch, k, k);
+    WH = arena_matrix(&scratch, batch, k);
+    HHtH = arena_matrix(&scratch, batch, k);
+    H_batch = arena_matrix(&scratch, batch, k);
+    W_rows = (double **)arena_alloc(&scratch, batch * sizeof(double *));
+    H_rows = (double **)arena_alloc(&scratch, batch * sizeof(double *));
+    perm = (int *)arena_alloc(&scratch, n * sizeof(int));
+    if (H_epoch == NULL || H_diff == NULL || G == NULL || WH == NULL || HHtH == NULL || H_batch == NULL
+        || W_rows == NULL || H_rows == NULL || perm == NULL) {
+        arena_release(&scratch);
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    begin_iterations(stats, stats != NULL ? calc_frobenius_squared_norm(W, n, n) : 0.0);
+
+    for (epoch = 0; epoch < MAX_ITER && !done; epoch++){
+        copy_matrix(H_epoch, H, n, k);
+        if (stats != NULL) {
+            /* a full pass over W, so it is only paid when telemetry is on */
+            if (symnmf_objective(&stats->objective[stats->iterations], W, H, n, k, 1) != 0) {
+                arena_release(&scratch);
+                return NULL;
+            }
+        }
+
+        /* recomputed once per epoch so the incremental updates cannot drift */
+        start = STATS_START(stats);
+        for (i = 0; i < k; i++) {
+            for (j = 0; j < k; j++) {
+                G[i][j] = 0.0;
+            }
+        }
+        add_outer_products(G, H, n, k, 1.0);
+        STATS_STOP(stats, PHASE_HHT, start);
+
+        for (i = n - 1; i > 0; i--) {
+            j = (int)((i + 1) * ((double)rand() / ((double)RAND_MAX + 1.0)));
+            tmp = perm[i];
+            perm[i] = perm[j];
+            perm[j] = tmp;
+        }
+
+        for (b0 = 0; b0 < n; b0 += batch) {
+            b = b0 + batch < n ? batch : n - b0;
+            for (i = 0; i < b; i++) {
+                W_rows[i] = W[perm[b0 + i]];
+                H_rows[i] = H[perm[b0 + i]];
+            }
+
+            start = STATS_START(stats);
+            multiply_matrixes_into(WH, W_rows, H, b, n, k);
+            STATS_STOP(stats, PHASE_WH, start);
+
+            start = STATS_START(stats);
+            multiply_matrixes_into(HHtH, H_rows, G, b, k, k);
+            STATS_STOP(stats, PHASE_HHTH, start);
+
+            start = STATS_START(stats);
+            copy_matrix(H_batch, H_rows, b, k);
+            apply_update(H_rows, WH, HHtH, b, k, NULL);
+            STATS_STOP(stats, PHASE_UPDATE, start);
+
+            start = STATS_START(stats);
+            add_outer_products(G, H_batch, b, k, -1.0);
+            add_outer_products(G, H_rows, b, k, 1.0);
+            STATS_STOP(stats, PHASE_HHT, start);
+        }
+
+        start = STATS_START(stats);
+        calc_mat_difference(H_diff, H, H_epoch, n, k);
+        f_norm_diff = calc_frobenius_squared_norm(H_diff, n, k);
+        STATS_STOP(stats, PHASE_CONVERGENCE, start);
+        done = f_norm_diff < EPS;
+        if (end_iteration(stats, epoch, f_norm_diff, done)) {
+            break;
+        }
+    }
+
+    arena_release(&scratch);
+    return H;
+}
+
+double** symnmf_nystrom(double **H, const nystrom *ny, const int k, symnmf_stats *stats){
+    int iter, done = 0, failed = 0, n = ny->n;
+    double f_norm_diff, start, w_squared_norm = 0.0;
+    double **H_old, **H_diff, **WH, **HHtH, **Ht, **HtH, **T;
+    arena scratch;
+
+    arena_init(&scratch, 4 * arena_matrix_bytes(n, k) + arena_matrix_bytes(k, n) + arena_matrix_bytes(k, k)
+                         + arena_matrix_bytes(ny->m, k));
+    H_old = arena_matrix(&scratch, n, k);
+    H_diff = arena_matrix(&scratch, n, k);
+    WH = arena_matrix(&scratch, n, k);
+    HHtH = arena_matrix(&scratch, n, k);
+    Ht = arena_matrix(&scratch, k, n);
+    HtH = arena_matrix(&scratch, k, k);
+    T = arena_matrix(&scratch, ny->m, k);
+    if (stats != NULL) {
+        failed = nystrom_squared_norm(&w_squared_norm, ny);
+    }
+    if (H_old == NULL || H_diff == NULL || WH == NULL || HHtH == NULL || Ht == NULL || HtH == NULL
+        || T == NULL || failed) {
+        arena_release(&scratch);
+        return NULL;
+    }
+    begin_iterations(stats, w_squared_norm);
+
+    for (iter = 0; iter < MAX_ITER && !done; iter++){
+        copy_matrix(H_old, H, n, k);
+
+        start = STATS_START(stats);
+        nystrom_multiply(WH, ny, H, k, T);
+        STATS_STOP(stats, PHASE_WH, start);
+
+        /* HH^T H as H (H^T H), so no n x n matrix is formed here either */
+        start = STATS_START(stats);
+        calc_transpose_into(Ht, H, n, k);
+        multiply_matrixes_into(HtH, Ht, H, k, n, k);
+        STATS_STOP(stats, PHASE_HHT, start);
+
+        start = STATS_START(stats);
+        multiply_matrixes_into(HHtH, H, HtH, n, k, k);
+        STATS_STOP(stats, PHASE_HHTH, start);
+
+        apply_update(H, WH, HHtH, n, k, stats);
+
+        start = STATS_START(stats);
         calc_mat_difference(H_diff, H, H_old, n, k);
         f_norm_diff = calc_frobenius_squared_norm(H_diff, n, k);
-        if (f_norm_diff < EPS){
+        STATS_STOP(stats, PHASE_CONVERGENCE, start);
+        done = f_norm_diff < EPS;
+        if (end_iteration(stats, iter, f_norm_diff, done)) {
             break;
-        } 
+        }
     }
-    
-    free_matrix(H_old, n);
-    free_matrix(H_diff, n);
+
+    arena_release(&scratch);
     return H;
 }
 
+#ifndef SYMNMF_NO_MAIN
+/**
+ * @brief Options following the goal and file name on the command line.
+ */
+typedef struct {
+    int k;
+    int threads;
+    int landmarks;
+    int batch;
+    int pages;
+    int placed;
+    int shards;
+    int shard_backend;
+    int tile;
+    int interval;
+    int persist_W;
+    const char *checkpoint_path;
+    symnmf_stats *stats;
+} cli_options;
+
+/**
+ * @brief Parse the optional arguments: --stats, --k K, --checkpoint PATH,
+ *        --interval N, --persist-w, --threads N, --landmarks M, --batch B,
+ *        --pages default|thp|hugetlb, --shards N, --loopback and --tile T.
+ *
+ * @return 0 on success, 1 on invalid arguments.
+ */
+int parse_cli_options(int argc, char *argv[], cli_options *opts, symnmf_stats *stats_storage){
+    int i;
+    for (i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            opts->stats = stats_storage;
+            stats_init(opts->stats, NULL, NULL);
+        } else if (strcmp(argv[i], "--persist-w") == 0) {
+            opts->persist_W = 1;
+        } else if (strcmp(argv[i], "--loopback") == 0) {
+            opts->shard_backend = SHARD_LOOPBACK;
+        } else if (i + 1 >= argc) {
+            return 1;
+        } else if (strcmp(argv[i], "--k") == 0) {
+            opts->k = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint") == 0) {
+            opts->checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--interval") == 0) {
+            opts->interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            opts->threads = atoi(argv[++i]);
+            opts->placed = 1;
+        } else if (strcmp(argv[i], "--landmarks") == 0) {
+            opts->landmarks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            opts->batch = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pages") == 0) {
+            opts->pages = placement_parse_pages(argv[++i]);
+            opts->placed = 1;
+        } else if (strcmp(argv[i], "--shards") == 0) {
+            opts->shards = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tile") == 0) {
+            opts->tile = atoi(argv[++i]);
+        } else {
+            return 1;
+        }
+    }
+    return opts->interval <= 0 || opts->pages < 0;
+}
+
+/**
+ * @brief Run the symnmf goal on the Nystrom approximation of W with opts->landmarks landmarks.
+ *
+ * @return H, NULL on failure.
+ */
+double** run_nystrom_goal(double **X, const int n, const int d, const cli_options *opts){
+    double **H = NULL, **res = NULL;
+    nystrom ny;
+
+    srand(0);
+    if (nystrom_build(&ny, X, n, d, opts->landmarks, opts->stats) != 0) {
+        return NULL;
+    }
+    H = allocate_matrix(n, opts->k);
+    if (H != NULL) {
+        initialize_H_from_mean(H, n, opts->k, nystrom_mean(&ny));
+        res = symnmf_nystrom(H, &ny, opts->k, opts->stats);
+    }
+    nystrom_free(&ny);
+    if (res == NULL) {
+        free_matrix(H, n);
+    }
+    return res;
+}
+
+/**
+ * @brief Run the symnmf goal, optionally checkpointing to opts->checkpoint_path.
+ *
+ * @return H, NULL on failure.
+ */
+double** run_symnmf_goal(double **X, const int n, const int d, const cli_options *opts){
+    double **W, **H, **res;
+    checkpoint cp;
+
+    if (opts->k <= 0 || opts->k >= n) {
+        return NULL;
+    }
+    if (opts->landmarks > 0) {
+        /* the approximation is cheap to rebuild, so it is not checkpointed */
+        return opts->checkpoint_path == NULL && opts->batch == 0 ? run_nystrom_goal(X, n, d, opts) : NULL;
+    }
+    if (opts->batch < 0 || (opts->batch > 0 && opts->checkpoint_path != NULL)) {
+        return NULL;
+    }
+    if (opts->shards > 0) {
+        /* the workers build their own rows of W, so none of the other modes apply */
+        if (opts->batch > 0 || opts->checkpoint_path != NULL) {
+            return NULL;
+        }
+        srand(0);
+        return symnmf_sharded(X, n, d, opts->k, opts->shards, opts->shard_backend, opts->stats);
+    }
+    W = norm(X, n, d, opts->stats);
+    H = allocate_matrix(n, opts->k);
+    if (W == NULL || H == NULL) {
+        free_matrix(W, n);
+        free_matrix(H, n);
+        return NULL;
+    }
+    srand(0);
+    initialize_H(H, W, n, opts->k);
+
+    if (opts->batch > 0) {
+        res = symnmf_minibatch(H, W, n, opts->k, opts->batch, opts->stats);
+    } else if (opts->checkpoint_path == NULL) {
+        res = symnmf(H, W, n, opts->k, opts->stats);
+    } else if (checkpoint_create(&cp, opts->checkpoint_path, n, opts->k, opts->persist_W ? W : NULL) == 0) {
+        res = symnmf_checkpoint(H, W, n, opts->k, &cp, opts->interval, opts->stats);
+        checkpoint_close(&cp);
+    } else {
+        res = NULL;
+    }
+    free_matrix(W, n);
+    if (res == NULL) {
+        free_matrix(H, n);
+    }
+    return res;
+}
+
+/**
+ * @brief Continue the run saved in opts->checkpoint_path. W is taken from the
+ *        checkpoint when it was persisted and recomputed from X otherwise.
+ *
+ * @param k Output, the number of clusters stored in the checkpoint.
+ * @return H, NULL on failure.
+ */
+double** run_resume_goal(double **X, const int n, const int d, const cli_options *opts, int *k){
+    double **W = NULL, **H = NULL, **res = NULL;
+    checkpoint cp;
+
+    if (opts->checkpoint_path == NULL || checkpoint_open(&cp, opts->checkpoint_path) != 0) {
+        return NULL;
+    }
+    *k = cp.header->k;
+    if (cp.header->n == n) {
+        if (cp.header->has_W) {
+            W = allocate_placed_matrix(n, n, opts->stats);
+            if (W != NULL) {
+                checkpoint_load_W(&cp, W);
+            }
+        } else {
+            W = norm(X, n, d, opts->stats);
+        }
+        H = allocate_matrix(n, *k);
+    }
+    if (W != NULL && H != NULL) {
+        checkpoint_load_H(&cp, H);
+        res = symnmf_checkpoint(H, W, n, *k, &cp, opts->interval, opts->stats);
+    }
+    checkpoint_close(&cp);
+    free_matrix(W, n);
+    if (res == NULL) {
+        free_matrix(H, n);
+    }
+    return res;
+}
+
+/**
+ * @brief Factorize X and print the hard assignment (assign), the silhouette
+ *        score (silhouette) or the SymNMF objective (objective).
+ *
+ * The similarity matrix is computed once and reused both for W and for
+ * the silhouette distances.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int run_quality_goal(double **X, const int n, const int d, const char *goal, const cli_options *opts){
+    int i, k = opts->k, status = 1;
+    int *labels;
+    double **A, **W = NULL, **H;
+    double score = 0.0;
+
+    if (k <= 0 || k >= n) {
+        return 1;
+    }
+    A = sym(X, n, d, opts->stats);
+    if (A != NULL) {
+        W = norm_from_sym(A, n, opts->stats);
+    }
+    H = allocate_matrix(n, k);
+    labels = (int *)malloc(n * sizeof(int));
+
+    if (A != NULL && W != NULL && H != NULL && labels != NULL) {
+        srand(0);
+        initialize_H(H, W, n, k);
+        if (symnmf(H, W, n, k, opts->stats) != NULL) {
+            assign_clusters(labels, H, n, k);
+            if (strcmp(goal, "assign") == 0) {
+                for (i = 0; i < n; i++) {
+                    printf("%d%c", labels[i], i < n - 1 ? DELIMITER : '\n');
+                }
+                status = 0;
+            } else if (strcmp(goal, "silhouette") == 0) {
+                status = silhouette_score(&score, X, n, d, labels, k, A, opts->threads);
+            } else {
+                status = symnmf_objective(&score, W, H, n, k, opts->threads);
+            }
+            if (status == 0 && strcmp(goal, "assign") != 0) {
+                printf("%.4f\n", score);
+            }
+        }
+    }
+    free_matrix(A, n);
+    free_matrix(W, n);
+    free_matrix(H, n);
+    free(labels);
+    return status;
+}
 
 int main(int argc, char *argv[]){
-    int n, d;
+    int n, d, cols;
     double **X;
     double **res = NULL;
+    double start;
     char *goal, *file_name;
+    symnmf_stats stats_storage;
+    cli_options opts;
+
+    opts.k = 0;
+    opts.threads = 0;
+    opts.landmarks = 0;
+    opts.batch = 0;
+    opts.pages = PAGES_DEFAULT;
+    opts.placed = 0;
+    opts.shards = 0;
+    opts.shard_backend = SHARD_PROCESSES;
+    opts.tile = 0;
+    opts.interval = DEFAULT_CHECKPOINT_INTERVAL;
+    opts.persist_W = 0;
+    opts.checkpoint_path = NULL;
+    opts.stats = NULL;
 
-    if(argc < 3){
+    if(argc < 3 || parse_cli_options(argc, argv, &opts, &stats_storage) != 0){
         /** This will not happen because based on the instructions
          *  we can assume all the arguments are valid.
          *  we needed to use argc otherwise the code would not be able to compile.
@@ -244,19 +900,42 @@ int main(int argc, char *argv[]){
     }
     goal = argv[1];
     file_name = argv[2];
+    if (opts.placed) {
+        /* without --pages or --threads, runs stay single-threaded on allocate_matrix */
+        placement_configure(opts.pages, opts.threads);
+    }
+    tiles_configure(opts.tile);
+
+    start = STATS_START(opts.stats);
     X = read_data(file_name, &n, &d);
+    STATS_STOP(opts.stats, PHASE_READ, start);
 
     if (X == NULL){
         printf("%s\n", ERROR_MESSAGE);
         return 1;
     }
 
+    cols = n;
     if (strcmp(goal, "sym") == 0) {
-        res = sym(X, n, d);
+        res = sym(X, n, d, opts.stats);
     } else if (strcmp(goal, "ddg") == 0) {
-        res = ddg(X, n, d);
+        res = ddg(X, n, d, opts.stats);
     } else if (strcmp(goal, "norm") == 0) {
-        res = norm(X, n, d);
+        res = norm(X, n, d, opts.stats);
+    } else if (strcmp(goal, "symnmf") == 0) {
+        res = run_symnmf_goal(X, n, d, &opts);
+        cols = opts.k;
+    } else if (strcmp(goal, "resume") == 0) {
+        res = run_resume_goal(X, n, d, &opts, &cols);
+    } else if (strcmp(goal, "assign") == 0 || strcmp(goal, "silhouette") == 0
+               || strcmp(goal, "objective") == 0) {
+        if (run_quality_goal(X, n, d, goal, &opts) != 0) {
+            free_matrix(X, n);
+            printf("%s\n", ERROR_MESSAGE);
+            return 1;
+        }
+        free_matrix(X, n);
+        return 0;
     }
     
     free_matrix(X, n);
@@ -264,7 +943,13 @@ int main(int argc, char *argv[]){
         printf("%s\n", ERROR_MESSAGE);
         return 1;
     }
-    print_matrix(res, n, n);
+    print_matrix(res, n, cols);
     free_matrix(res, n);
+    if (opts.stats != NULL) {
+        /* the report goes to stderr so the matrix on stdout stays parseable */
+        stats_finish(opts.stats);
+        stats_print(stderr, opts.stats);
+    }
     return 0;
 }
+#endif
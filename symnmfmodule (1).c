@@ -1,6 +1,8 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <unistd.h>
 #include "symnmf.h"
+#include "job_pool.h"
 
 enum Action{
     SYM,
@@ -8,6 +10,11 @@ enum Action{
     NORM,
 };
 
+PyObject *execute_partial_symnmf(PyObject *args, enum Action action);
+
+/* worker pool behind submit_norm and submit_symnmf, started on first use */
+static job_pool *pool = NULL;
+
 int get_matrix_rows(PyObject *py_mat){
     if (!PyList_Check(py_mat)) {
         return 0;
@@ -45,7 +52,7 @@ double** PyObject_to_double_mat(PyObject *py_mat, int N, int d){
         return NULL;
     }
     
-    double** mat = allocate_matrix(d, N);
+    double** mat = allocate_placed_matrix(N, d, NULL);
     if (mat == NULL){
         return NULL;
     }
@@ -175,13 +182,13 @@ PyObject *execute_partial_symnmf(PyObject *args, enum Action action){
 
     switch (action) {
         case SYM:
-            res_mat = sym(X, N, d);
+            res_mat = sym(X, N, d, NULL);
             break;
         case DDG:
-            res_mat = ddg(X, N, d);
+            res_mat = ddg(X, N, d, NULL);
             break;
         case NORM:
-            res_mat = norm(X, N, d);
+            res_mat = norm(X, N, d, NULL);
             break;
     }
 
@@ -238,7 +245,370 @@ PyObject *py_symnmf(PyObject *self, PyObject *args){
         return NULL;
     }
 
-    updated_H = symnmf(H, W, N, k);
+    updated_H = symnmf(H, W, N, k, NULL);
+
+    if (updated_H == NULL) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    py_res = double_mat_to_PyObject(updated_H, N, k);
+    free_matrix(H, N);
+    free_matrix(W, N);
+    return py_res;
+}
+
+int py_iter_callback(int iter, double objective, double delta, void *user){
+    PyObject *ret = PyObject_CallFunction((PyObject *)user, "idd", iter, objective, delta);
+    int stop;
+    if (ret == NULL) {
+        return 1;
+    }
+    stop = PyObject_IsTrue(ret);
+    Py_DECREF(ret);
+    return stop != 0;
+}
+
+PyObject *double_array_to_PyObject(const double *values, int count){
+    int i;
+    PyObject *pyList = PyList_New(count);
+    if (!pyList) {
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        PyObject *pyElement = PyFloat_FromDouble(values[i]);
+        if (!pyElement) {
+            Py_DECREF(pyList);
+            return NULL;
+        }
+        PyList_SetItem(pyList, i, pyElement);
+    }
+    return pyList;
+}
+
+PyObject *placement_to_PyObject(const stats_placement *p){
+    int i;
+    PyObject *nodes, *dict;
+    if (p->bytes == 0) {
+        Py_RETURN_NONE;
+    }
+    nodes = PyList_New(STATS_MAX_NODES);
+    if (!nodes) {
+        return NULL;
+    }
+    for (i = 0; i < STATS_MAX_NODES; i++) {
+        PyObject *count = PyLong_FromLong(p->numa_pages[i]);
+        if (!count) {
+            Py_DECREF(nodes);
+            return NULL;
+        }
+        PyList_SetItem(nodes, i, count);
+    }
+    dict = Py_BuildValue("{s:s,s:i,s:l,s:l,s:l,s:l,s:l,s:O}",
+                         "pages", p->pages,
+                         "threads", p->threads,
+                         "bytes", p->bytes,
+                         "page_size", p->page_size,
+                         "huge_bytes", p->huge_bytes,
+                         "numa_sampled", p->numa_sampled,
+                         "numa_local", p->numa_local,
+                         "numa_pages", nodes);
+    Py_DECREF(nodes);
+    return dict;
+}
+
+PyObject *stats_to_PyObject(const symnmf_stats *stats){
+    int i;
+    PyObject *phases = PyDict_New();
+    if (!phases) {
+        return NULL;
+    }
+    for (i = 0; i < PHASE_COUNT; i++) {
+        PyObject *seconds = PyFloat_FromDouble(stats->phase_time[i]);
+        if (!seconds || PyDict_SetItemString(phases, stats_phase_name(i), seconds) != 0) {
+            Py_XDECREF(seconds);
+            Py_DECREF(phases);
+            return NULL;
+        }
+        Py_DECREF(seconds);
+    }
+
+    PyObject *objective = double_array_to_PyObject(stats->objective, stats->iterations);
+    PyObject *delta = double_array_to_PyObject(stats->delta, stats->iterations);
+    PyObject *placement = placement_to_PyObject(&stats->placement);
+    PyObject *dict = NULL;
+    if (objective && delta && placement) {
+        dict = Py_BuildValue("{s:i,s:O,s:O,s:l,s:l,s:l,s:O,s:O,s:O,s:O}",
+                             "iterations", stats->iterations,
+                             "converged", stats->converged ? Py_True : Py_False,
+                             "interrupted", stats->interrupted ? Py_True : Py_False,
+                             "allocations", stats->allocations,
+                             "tasks", stats->tasks,
+                             "steals", stats->steals,
+                             "phases", phases,
+                             "objective", objective,
+                             "delta", delta,
+                             "placement", placement);
+    }
+    Py_DECREF(phases);
+    Py_XDECREF(objective);
+    Py_XDECREF(delta);
+    Py_XDECREF(placement);
+    return dict;
+}
+
+PyDoc_STRVAR(symnmf_stats_doc,
+"symnmf_stats(arg1, arg2, arg3, arg4, arg5=None)\n"
+"Same as symnmf, and also returns the telemetry of the run\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): H - initial H.\n"
+"    arg2 (float[][]): W - normalized similarity matrix.\n"
+"    arg3 (int): N - number of rows in the original data.\n"
+"    arg4 (int): k - number of required cluesters.\n"
+"    arg5 (callable): optional callback(iter, objective, delta), called after\n"
+"        every iteration. Returning a true value stops the iterations.\n"
+"\n"
+"Returns:\n"
+"    (float[][], dict): H and a dict with the keys iterations, converged,\n"
+"        interrupted, allocations, phases (seconds per phase), objective and\n"
+"        delta (one entry per iteration)\n");
+
+PyObject *py_symnmf_stats(PyObject *self, PyObject *args){
+    PyObject *py_H, *py_W, *py_callback = Py_None, *py_res, *py_stats;
+    double **H, **W;
+    int N, k;
+    symnmf_stats stats;
+
+    if (!PyArg_ParseTuple(args, "OOii|O", &py_H, &py_W, &N, &k, &py_callback)) {
+        return NULL;
+    }
+
+    if (!PyList_Check(py_H) || !PyList_Check(py_W)) {
+        return NULL;
+    }
+
+    if (py_callback != Py_None && !PyCallable_Check(py_callback)) {
+        PyErr_SetString(PyExc_TypeError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    H = PyObject_to_double_mat(py_H, N, k);
+    W = PyObject_to_double_mat(py_W, N, N);
+
+    if (H == NULL || W == NULL) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        return NULL;
+    }
+
+    stats_init(&stats, py_callback == Py_None ? NULL : py_iter_callback, py_callback);
+    if (symnmf(H, W, N, k, &stats) == NULL || PyErr_Occurred()) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        if (!PyErr_Occurred()) {
+            PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+        }
+        return NULL;
+    }
+    stats_finish(&stats);
+
+    py_res = double_mat_to_PyObject(H, N, k);
+    py_stats = stats_to_PyObject(&stats);
+    free_matrix(H, N);
+    free_matrix(W, N);
+    if (!py_res || !py_stats) {
+        Py_XDECREF(py_res);
+        Py_XDECREF(py_stats);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", py_res, py_stats);
+}
+
+PyDoc_STRVAR(symnmf_checkpoint_doc,
+"symnmf_checkpoint(arg1, arg2, arg3, arg4, arg5, arg6=10, arg7=False)\n"
+"Same as symnmf, and checkpoints the run to a memory-mapped file\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): H - initial H.\n"
+"    arg2 (float[][]): W - normalized similarity matrix.\n"
+"    arg3 (int): N - number of rows in the original data.\n"
+"    arg4 (int): k - number of required cluesters.\n"
+"    arg5 (str): path of the checkpoint file, created or truncated.\n"
+"    arg6 (int): number of iterations between checkpoints.\n"
+"    arg7 (bool): also persist W so symnmf_resume does not need it.\n"
+"\n"
+"Returns:\n"
+"    float[][]: factorized matrix H\n");
+
+PyObject *py_symnmf_checkpoint(PyObject *self, PyObject *args){
+    PyObject *py_H, *py_W, *py_res;
+    const char *path;
+    double **H, **W, **updated_H = NULL;
+    int N, k, interval = DEFAULT_CHECKPOINT_INTERVAL, persist_W = 0;
+    checkpoint cp;
+
+    if (!PyArg_ParseTuple(args, "OOiis|ip", &py_H, &py_W, &N, &k, &path, &interval, &persist_W)) {
+        return NULL;
+    }
+
+    if (!PyList_Check(py_H) || !PyList_Check(py_W) || interval <= 0) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    H = PyObject_to_double_mat(py_H, N, k);
+    W = PyObject_to_double_mat(py_W, N, N);
+
+    if (H == NULL || W == NULL) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        return NULL;
+    }
+
+    if (checkpoint_create(&cp, path, N, k, persist_W ? W : NULL) == 0) {
+        updated_H = symnmf_checkpoint(H, W, N, k, &cp, interval, NULL);
+        checkpoint_close(&cp);
+    }
+
+    if (updated_H == NULL) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    py_res = double_mat_to_PyObject(updated_H, N, k);
+    free_matrix(H, N);
+    free_matrix(W, N);
+    return py_res;
+}
+
+PyDoc_STRVAR(symnmf_resume_doc,
+"symnmf_resume(arg1, arg2=None, arg3=10, arg4=None)\n"
+"Continues a run saved by symnmf_checkpoint from its last saved iteration\n"
+"\n"
+"Parameters:\n"
+"    arg1 (str): path of the checkpoint file.\n"
+"    arg2 (float[][]): W - normalized similarity matrix, may be None when the\n"
+"        checkpoint persisted W or arg4 is given.\n"
+"    arg3 (int): number of iterations between checkpoints.\n"
+"    arg4 (float[][]): X - data points, used to recompute W with norm when\n"
+"        arg2 is None and the checkpoint did not persist W.\n"
+"\n"
+"Returns:\n"
+"    float[][]: factorized matrix H\n");
+
+PyObject *py_symnmf_resume(PyObject *self, PyObject *args){
+    PyObject *py_W = Py_None, *py_X = Py_None, *py_res = NULL;
+    const char *path;
+    double **H = NULL, **W = NULL, **X;
+    int N, d, k, interval = DEFAULT_CHECKPOINT_INTERVAL;
+    checkpoint cp;
+
+    if (!PyArg_ParseTuple(args, "s|OiO", &path, &py_W, &interval, &py_X)) {
+        return NULL;
+    }
+    if ((py_W != Py_None && !PyList_Check(py_W)) || (py_X != Py_None && !PyList_Check(py_X)) || interval <= 0) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+    if (checkpoint_open(&cp, path) != 0) {
+        PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+        return NULL;
+    }
+    N = cp.header->n;
+    k = cp.header->k;
+
+    if (py_W != Py_None) {
+        if (get_matrix_rows(py_W) != N || get_matrix_cols(py_W) != N) {
+            checkpoint_close(&cp);
+            PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+            return NULL;
+        }
+        W = PyObject_to_double_mat(py_W, N, N);
+    } else if (!cp.header->has_W && py_X != Py_None) {
+        /* as the resume goal of the CLI does */
+        d = get_matrix_cols(py_X);
+        if (get_matrix_rows(py_X) != N || d <= 0) {
+            checkpoint_close(&cp);
+            PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+            return NULL;
+        }
+        X = PyObject_to_double_mat(py_X, N, d);
+        if (X == NULL) {
+            checkpoint_close(&cp);
+            return NULL;
+        }
+        W = norm(X, N, d, NULL);
+        free_matrix(X, N);
+    } else {
+        W = allocate_placed_matrix(N, N, NULL);
+        if (W != NULL && checkpoint_load_W(&cp, W) != 0) {
+            free_matrix(W, N);
+            W = NULL;
+        }
+    }
+    H = allocate_matrix(N, k);
+
+    if (H != NULL && W != NULL) {
+        checkpoint_load_H(&cp, H);
+        if (symnmf_checkpoint(H, W, N, k, &cp, interval, NULL) != NULL) {
+            py_res = double_mat_to_PyObject(H, N, k);
+        }
+    }
+    checkpoint_close(&cp);
+    free_matrix(H, N);
+    free_matrix(W, N);
+    if (py_res == NULL && !PyErr_Occurred()) {
+        PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+    }
+    return py_res;
+}
+
+PyDoc_STRVAR(symnmf_minibatch_doc,
+"symnmf_minibatch(arg1, arg2, arg3, arg4, arg5, arg6=0)\n"
+"Same as symnmf, updating random blocks of arg5 rows of H per step\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): H - initial H.\n"
+"    arg2 (float[][]): W - normalized similarity matrix.\n"
+"    arg3 (int): N - number of rows in the original data.\n"
+"    arg4 (int): k - number of required cluesters.\n"
+"    arg5 (int): number of rows of H updated per step.\n"
+"    arg6 (int): seed of the row shuffling.\n"
+"\n"
+"Returns:\n"
+"    float[][]: factorized matrix H\n");
+
+PyObject *py_symnmf_minibatch(PyObject *self, PyObject *args){
+    PyObject *py_H, *py_W, *py_res;
+    double **H, **W, **updated_H;
+    int N, k, batch_size;
+    unsigned int seed = 0;
+
+    if (!PyArg_ParseTuple(args, "OOiii|I", &py_H, &py_W, &N, &k, &batch_size, &seed)) {
+        return NULL;
+    }
+
+    if (!PyList_Check(py_H) || !PyList_Check(py_W) || batch_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    H = PyObject_to_double_mat(py_H, N, k);
+    W = PyObject_to_double_mat(py_W, N, N);
+
+    if (H == NULL || W == NULL) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        return NULL;
+    }
+
+    srand(seed);
+    updated_H = symnmf_minibatch(H, W, N, k, batch_size, NULL);
 
     if (updated_H == NULL) {
         free_matrix(H, N);
@@ -250,16 +620,633 @@ PyObject *py_symnmf(PyObject *self, PyObject *args){
     py_res = double_mat_to_PyObject(updated_H, N, k);
     free_matrix(H, N);
     free_matrix(W, N);
-    free_matrix(updated_H, N);
     return py_res;
 }
 
+PyDoc_STRVAR(symnmf_nystrom_doc,
+"symnmf_nystrom(arg1, arg2, arg3, arg4=0)\n"
+"It solves the symNMF algorithm against a Nystrom approximation of W\n"
+"\n"
+"Only the affinities between the data points and arg3 landmark points are\n"
+"computed, so memory and time per iteration are O(N*m) instead of O(N^2).\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): X - data points.\n"
+"    arg2 (int): k - number of required cluesters.\n"
+"    arg3 (int): m - number of landmarks; larger is more accurate and slower.\n"
+"    arg4 (int): seed of the landmark sampling and of the initial H.\n"
+"\n"
+"Returns:\n"
+"    float[][]: factorized matrix H\n");
+
+PyObject *py_symnmf_nystrom(PyObject *self, PyObject *args){
+    PyObject *py_X, *py_res = NULL;
+    double **X, **H = NULL;
+    int N, d, k, m;
+    unsigned int seed = 0;
+    nystrom ny;
+
+    if (!PyArg_ParseTuple(args, "Oii|I", &py_X, &k, &m, &seed)) {
+        return NULL;
+    }
+    N = get_matrix_rows(py_X);
+    d = get_matrix_cols(py_X);
+    if (!PyList_Check(py_X) || k <= 0 || k >= N || m <= 0) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    X = PyObject_to_double_mat(py_X, N, d);
+    if (X == NULL) {
+        return NULL;
+    }
+
+    srand(seed);
+    if (nystrom_build(&ny, X, N, d, m, NULL) == 0) {
+        H = allocate_matrix(N, k);
+        if (H != NULL) {
+            initialize_H_from_mean(H, N, k, nystrom_mean(&ny));
+            if (symnmf_nystrom(H, &ny, k, NULL) != NULL) {
+                py_res = double_mat_to_PyObject(H, N, k);
+            }
+        }
+        nystrom_free(&ny);
+    }
+    free_matrix(X, N);
+    free_matrix(H, N);
+    if (py_res == NULL && !PyErr_Occurred()) {
+        PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+    }
+    return py_res;
+}
+
+PyDoc_STRVAR(symnmf_sharded_doc,
+"symnmf_sharded(arg1, arg2, arg3, arg4=False, arg5=0)\n"
+"It solves the symNMF algorithm with W split by rows across arg3 workers\n"
+"\n"
+"Each worker builds and keeps only its own rows of W; the workers exchange\n"
+"their rows of H and k x k Gram matrices every iteration.\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): X - data points.\n"
+"    arg2 (int): k - number of required cluesters.\n"
+"    arg3 (int): number of workers, between 1 and N.\n"
+"    arg4 (bool): run the workers as threads of this process instead of\n"
+"        forked processes. Always the case once submit_norm or submit_symnmf\n"
+"        has started the worker pool, since forking next to its threads is\n"
+"        not safe.\n"
+"    arg5 (int): seed of the initial H.\n"
+"\n"
+"Returns:\n"
+"    float[][]: factorized matrix H\n");
+
+PyObject *py_symnmf_sharded(PyObject *self, PyObject *args){
+    PyObject *py_X, *py_res = NULL;
+    double **X, **H;
+    int N, d, k, shards, loopback = 0;
+    unsigned int seed = 0;
+
+    if (!PyArg_ParseTuple(args, "Oii|pI", &py_X, &k, &shards, &loopback, &seed)) {
+        return NULL;
+    }
+    N = get_matrix_rows(py_X);
+    d = get_matrix_cols(py_X);
+    if (!PyList_Check(py_X) || k <= 0 || k >= N || shards <= 0 || shards > N) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    X = PyObject_to_double_mat(py_X, N, d);
+    if (X == NULL) {
+        return NULL;
+    }
+
+    srand(seed);
+    /* a pool thread may hold the malloc lock at the fork, leaving the child stuck on it */
+    if (pool != NULL) {
+        loopback = 1;
+    }
+    H = symnmf_sharded(X, N, d, k, shards, loopback ? SHARD_LOOPBACK : SHARD_PROCESSES, NULL);
+    if (H != NULL) {
+        py_res = double_mat_to_PyObject(H, N, k);
+    }
+    free_matrix(X, N);
+    free_matrix(H, N);
+    if (py_res == NULL && !PyErr_Occurred()) {
+        PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+    }
+    return py_res;
+}
+
+PyDoc_STRVAR(set_placement_doc,
+"set_placement(arg1='default', arg2=1)\n"
+"It sets how the large matrices (A, W) of later calls are allocated\n"
+"\n"
+"Parameters:\n"
+"    arg1 (str): 'default', 'thp' for transparent huge pages, or 'hugetlb'\n"
+"        for the reserved huge page pool; each falls back to the previous one.\n"
+"    arg2 (int): number of threads that first-touch and compute on the row\n"
+"        blocks of those matrices, each pinned to its own CPU, 0 for one per\n"
+"        CPU.\n"
+"\n"
+"Returns:\n"
+"    None\n");
+
+static PyObject *py_set_placement(PyObject *self, PyObject *args){
+    const char *name = "default";
+    int pages, threads = 1;
+
+    if (!PyArg_ParseTuple(args, "|si", &name, &threads)) {
+        return NULL;
+    }
+    pages = placement_parse_pages(name);
+    if (pages < 0) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+    placement_configure(pages, threads);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(set_tiles_doc,
+"set_tiles(arg1=0)\n"
+"It sets whether sym, ddg, norm and the symnmf updates of later calls run\n"
+"as tiled task graphs on the threads given to set_placement\n"
+"\n"
+"The tiles are scheduled by work stealing, and the degree and normalize\n"
+"tiles start as soon as the tiles they read are done. Results are the same\n"
+"as without tiling.\n"
+"\n"
+"Parameters:\n"
+"    arg1 (int): rows and columns per tile, 0 to turn tiling off.\n"
+"\n"
+"Returns:\n"
+"    None\n");
+
+static PyObject *py_set_tiles(PyObject *self, PyObject *args){
+    int tile = 0;
+
+    if (!PyArg_ParseTuple(args, "|i", &tile)) {
+        return NULL;
+    }
+    if (tile < 0) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+    tiles_configure(tile);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(assign_doc,
+"assign(arg1)\n"
+"It returns the hard cluster assignment of every data point\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): H - factorized matrix returned by symnmf.\n"
+"\n"
+"Returns:\n"
+"    int[]: index of the largest entry in every row of H\n");
+
+static PyObject *py_assign(PyObject *self, PyObject *args){
+    PyObject *py_H, *py_res;
+    double **H;
+    int *labels;
+    int i, N, k;
+
+    if (!PyArg_ParseTuple(args, "O", &py_H)) {
+        return NULL;
+    }
+    if (!PyList_Check(py_H)) {
+        return NULL;
+    }
+
+    N = get_matrix_rows(py_H);
+    k = get_matrix_cols(py_H);
+    H = PyObject_to_double_mat(py_H, N, k);
+    if (H == NULL) {
+        return NULL;
+    }
+    labels = (int *)malloc(N * sizeof(int));
+    if (labels == NULL) {
+        free_matrix(H, N);
+        return PyErr_NoMemory();
+    }
+
+    assign_clusters(labels, H, N, k);
+    py_res = PyList_New(N);
+    for (i = 0; py_res && i < N; i++) {
+        PyObject *label = PyLong_FromLong(labels[i]);
+        if (!label) {
+            Py_CLEAR(py_res);
+            break;
+        }
+        PyList_SetItem(py_res, i, label);
+    }
+    free_matrix(H, N);
+    free(labels);
+    return py_res;
+}
+
+PyDoc_STRVAR(silhouette_doc,
+"silhouette(arg1, arg2, arg3=None, arg4=0)\n"
+"It returns the mean silhouette coefficient of a clustering\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): X - data points.\n"
+"    arg2 (int[]): cluster label of every data point, as returned by assign.\n"
+"    arg3 (float[][]): A - optional similarity matrix of X as returned by sym;\n"
+"        distances are then recovered from A instead of recomputed.\n"
+"    arg4 (int): number of threads, 0 for one per CPU.\n"
+"\n"
+"Returns:\n"
+"    float: silhouette score in [-1, 1]\n");
+
+static PyObject *py_silhouette(PyObject *self, PyObject *args){
+    PyObject *py_X, *py_labels, *py_A = Py_None;
+    double **X, **A = NULL;
+    double score;
+    int *labels;
+    int i, N, d, status, k = 0, threads = 0;
+
+    if (!PyArg_ParseTuple(args, "OO|Oi", &py_X, &py_labels, &py_A, &threads)) {
+        return NULL;
+    }
+    N = get_matrix_rows(py_X);
+    d = get_matrix_cols(py_X);
+    if (!PyList_Check(py_X) || !PyList_Check(py_labels) || PyList_Size(py_labels) != N
+        || (py_A != Py_None && (get_matrix_rows(py_A) != N || get_matrix_cols(py_A) != N))) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    labels = (int *)malloc(N * sizeof(int));
+    if (labels == NULL) {
+        return PyErr_NoMemory();
+    }
+    for (i = 0; i < N; i++) {
+        labels[i] = (int)PyLong_AsLong(PyList_GetItem(py_labels, i));
+        if (labels[i] < 0) {
+            free(labels);
+            if (!PyErr_Occurred()) {
+                PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+            }
+            return NULL;
+        }
+        if (labels[i] >= k) {
+            k = labels[i] + 1;
+        }
+    }
+
+    X = PyObject_to_double_mat(py_X, N, d);
+    if (X != NULL && py_A != Py_None) {
+        A = PyObject_to_double_mat(py_A, N, N);
+    }
+    if (X == NULL || (py_A != Py_None && A == NULL)) {
+        free_matrix(X, N);
+        free(labels);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    status = silhouette_score(&score, X, N, d, labels, k, A, threads);
+    Py_END_ALLOW_THREADS
+
+    free_matrix(X, N);
+    free_matrix(A, N);
+    free(labels);
+    if (status != 0) {
+        return PyErr_NoMemory();
+    }
+    return PyFloat_FromDouble(score);
+}
+
+PyDoc_STRVAR(objective_doc,
+"objective(arg1, arg2, arg3=0)\n"
+"It returns the SymNMF objective ||W - HH^T||_F^2 without forming HH^T\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): W - normalized similarity matrix.\n"
+"    arg2 (float[][]): H - factorized matrix.\n"
+"    arg3 (int): number of threads, 0 for one per CPU.\n"
+"\n"
+"Returns:\n"
+"    float: squared Frobenius norm of W - HH^T\n");
+
+static PyObject *py_objective(PyObject *self, PyObject *args){
+    PyObject *py_W, *py_H;
+    double **W, **H;
+    double value;
+    int N, k, status, threads = 0;
+
+    if (!PyArg_ParseTuple(args, "OO|i", &py_W, &py_H, &threads)) {
+        return NULL;
+    }
+    N = get_matrix_rows(py_H);
+    k = get_matrix_cols(py_H);
+    if (!PyList_Check(py_W) || !PyList_Check(py_H)
+        || get_matrix_rows(py_W) != N || get_matrix_cols(py_W) != N) {
+        PyErr_SetString(PyExc_ValueError, ERROR_MESSAGE);
+        return NULL;
+    }
+
+    W = PyObject_to_double_mat(py_W, N, N);
+    H = W != NULL ? PyObject_to_double_mat(py_H, N, k) : NULL;
+    if (W == NULL || H == NULL) {
+        free_matrix(W, N);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    status = symnmf_objective(&value, W, H, N, k, threads);
+    Py_END_ALLOW_THREADS
+
+    free_matrix(W, N);
+    free_matrix(H, N);
+    if (status != 0) {
+        return PyErr_NoMemory();
+    }
+    return PyFloat_FromDouble(value);
+}
+
+#define JOB_WAIT_SLICE 0.1
+
+static void shutdown_pool(void){
+    if (pool != NULL) {
+        job_pool_destroy(pool);
+        pool = NULL;
+    }
+}
+
+job_pool *get_pool(void){
+    long num_threads;
+    if (pool == NULL) {
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+        pool = job_pool_create(num_threads > 0 ? (int)num_threads : 1);
+        if (pool == NULL) {
+            PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+            return NULL;
+        }
+        Py_AtExit(shutdown_pool);
+    }
+    return pool;
+}
+
+typedef struct {
+    PyObject_HEAD
+    job *j;
+} JobObject;
+
+static const char *job_state_names[] = {"pending", "running", "done", "failed", "cancelled"};
+
+static void Job_dealloc(JobObject *self){
+    PyTypeObject *type = Py_TYPE(self);
+    if (self->j != NULL) {
+        if (pool != NULL) {
+            job_pool_cancel(pool, self->j);
+        }
+        job_release(pool, self->j);
+    }
+    type->tp_free((PyObject *)self);
+    Py_DECREF(type);
+}
+
+static PyObject *Job_poll(JobObject *self, PyObject *Py_UNUSED(ignored)){
+    enum JobState state = job_pool_poll(pool, self->j, NULL);
+    return PyBool_FromLong(state != JOB_PENDING && state != JOB_RUNNING);
+}
+
+static PyObject *Job_state(JobObject *self, PyObject *Py_UNUSED(ignored)){
+    return PyUnicode_FromString(job_state_names[job_pool_poll(pool, self->j, NULL)]);
+}
+
+static PyObject *Job_progress(JobObject *self, PyObject *Py_UNUSED(ignored)){
+    int iterations;
+    job_pool_poll(pool, self->j, &iterations);
+    return PyLong_FromLong(iterations);
+}
+
+static PyObject *Job_cancel(JobObject *self, PyObject *Py_UNUSED(ignored)){
+    return PyBool_FromLong(job_pool_cancel(pool, self->j));
+}
+
+static PyObject *Job_wait(JobObject *self, PyObject *args){
+    PyObject *py_timeout = Py_None;
+    double timeout = -1.0, slice;
+    int finished = 0;
+
+    if (!PyArg_ParseTuple(args, "|O", &py_timeout)) {
+        return NULL;
+    }
+    if (py_timeout != Py_None) {
+        timeout = PyFloat_AsDouble(py_timeout);
+        if (timeout == -1.0 && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (timeout < 0.0) {
+            timeout = 0.0;
+        }
+    }
+
+    /* wait in slices so Ctrl-C is still delivered */
+    for (;;) {
+        slice = (timeout < 0.0 || timeout > JOB_WAIT_SLICE) ? JOB_WAIT_SLICE : timeout;
+        Py_BEGIN_ALLOW_THREADS
+        finished = job_pool_wait(pool, self->j, slice);
+        Py_END_ALLOW_THREADS
+        if (finished || PyErr_CheckSignals() != 0) {
+            break;
+        }
+        if (timeout >= 0.0) {
+            timeout -= slice;
+            if (timeout <= 0.0) {
+                break;
+            }
+        }
+    }
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    return PyBool_FromLong(finished);
+}
+
+static PyObject *Job_result(JobObject *self, PyObject *Py_UNUSED(ignored)){
+    job *j = self->j;
+    PyObject *bytes, *view, *res;
+
+    switch (job_pool_poll(pool, j, NULL)) {
+        case JOB_DONE:
+            break;
+        case JOB_CANCELLED:
+            PyErr_SetString(PyExc_RuntimeError, "job was cancelled");
+            return NULL;
+        case JOB_FAILED:
+            PyErr_SetString(PyExc_RuntimeError, ERROR_MESSAGE);
+            return NULL;
+        default:
+            PyErr_SetString(PyExc_RuntimeError, "job has not finished");
+            return NULL;
+    }
+
+    /* allocate_matrix stores the rows contiguously starting at result[0] */
+    bytes = PyBytes_FromStringAndSize((const char *)j->result[0],
+                                      (Py_ssize_t)j->result_rows * j->result_cols * sizeof(double));
+    if (!bytes) {
+        return NULL;
+    }
+    view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (!view) {
+        return NULL;
+    }
+    res = PyObject_CallMethod(view, "cast", "s(ii)", "d", j->result_rows, j->result_cols);
+    Py_DECREF(view);
+    return res;
+}
+
+static PyMethodDef Job_methods[] = {
+    {"poll", (PyCFunction)Job_poll, METH_NOARGS, "poll()\nReturns True if the job has finished.\n"},
+    {"wait", (PyCFunction)Job_wait, METH_VARARGS,
+     "wait(timeout=None)\nBlocks until the job finishes or timeout seconds pass.\n"
+     "Returns True if the job has finished.\n"},
+    {"cancel", (PyCFunction)Job_cancel, METH_NOARGS,
+     "cancel()\nCancels a pending job, or stops a running symnmf job after its current iteration.\n"
+     "Returns False if the job had already finished.\n"},
+    {"progress", (PyCFunction)Job_progress, METH_NOARGS,
+     "progress()\nReturns the number of symnmf iterations completed so far.\n"},
+    {"state", (PyCFunction)Job_state, METH_NOARGS,
+     "state()\nReturns one of 'pending', 'running', 'done', 'failed', 'cancelled'.\n"},
+    {"result", (PyCFunction)Job_result, METH_NOARGS,
+     "result()\nReturns the result matrix as a 2-d memoryview of doubles.\n"
+     "Raises RuntimeError if the job is not done.\n"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot Job_slots[] = {
+    {Py_tp_dealloc, Job_dealloc},
+    {Py_tp_methods, Job_methods},
+    {Py_tp_doc, "Handle to a job running on the native worker pool.\n"
+                "Dropping the last reference cancels the job."},
+    {0, NULL}
+};
+
+static PyType_Spec Job_spec = {
+    "symnmfmodule.Job",
+    sizeof(JobObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    Job_slots
+};
+
+static PyObject *JobType = NULL;
+
+PyObject *submit_job(job *j){
+    job_pool *p = get_pool();
+    JobObject *self;
+
+    if (j == NULL || p == NULL) {
+        if (j != NULL) {
+            job_release(NULL, j);
+        } else if (!PyErr_Occurred()) {
+            PyErr_NoMemory();
+        }
+        return NULL;
+    }
+    self = PyObject_New(JobObject, (PyTypeObject *)JobType);
+    if (!self) {
+        job_release(NULL, j);
+        return NULL;
+    }
+    self->j = j;
+    job_pool_submit(p, j);
+    return (PyObject *)self;
+}
+
+PyDoc_STRVAR(submit_norm_doc,
+"submit_norm(arg1)\n"
+"Queues norm on the native worker pool without blocking\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): X - data points.\n"
+"\n"
+"Returns:\n"
+"    Job: handle whose result() is the normalized similarity matrix W\n");
+
+static PyObject *py_submit_norm(PyObject *self, PyObject *args){
+    PyObject *py_X;
+    double **X;
+    int N, d;
+
+    if (!PyArg_ParseTuple(args, "O", &py_X)) {
+        return NULL;
+    }
+    if (!PyList_Check(py_X)) {
+        return NULL;
+    }
+
+    N = get_matrix_rows(py_X);
+    d = get_matrix_cols(py_X);
+    X = PyObject_to_double_mat(py_X, N, d);
+    if (X == NULL) {
+        return NULL;
+    }
+    return submit_job(job_create(JOB_NORM, X, NULL, NULL, N, d));
+}
+
+PyDoc_STRVAR(submit_symnmf_doc,
+"submit_symnmf(arg1, arg2, arg3, arg4)\n"
+"Queues symnmf on the native worker pool without blocking\n"
+"\n"
+"Parameters:\n"
+"    arg1 (float[][]): H - initial H.\n"
+"    arg2 (float[][]): W - normalized similarity matrix.\n"
+"    arg3 (int): N - number of rows in the original data.\n"
+"    arg4 (int): k - number of required cluesters.\n"
+"\n"
+"Returns:\n"
+"    Job: handle whose result() is the factorized H; progress() counts the\n"
+"        completed iterations\n");
+
+static PyObject *py_submit_symnmf(PyObject *self, PyObject *args){
+    PyObject *py_H, *py_W;
+    double **H, **W;
+    int N, k;
+
+    if (!PyArg_ParseTuple(args, "OOii", &py_H, &py_W, &N, &k)) {
+        return NULL;
+    }
+    if (!PyList_Check(py_H) || !PyList_Check(py_W)) {
+        return NULL;
+    }
+
+    H = PyObject_to_double_mat(py_H, N, k);
+    W = PyObject_to_double_mat(py_W, N, N);
+    if (H == NULL || W == NULL) {
+        free_matrix(H, N);
+        free_matrix(W, N);
+        return NULL;
+    }
+    return submit_job(job_create(JOB_SYMNMF, NULL, H, W, N, k));
+}
+
 
 static PyMethodDef symnmfMethods[] = {
     {"sym", py_sym, METH_VARARGS, sym_doc},
     {"ddg", py_ddg, METH_VARARGS, ddg_doc},
     {"norm", py_norm, METH_VARARGS, norm_doc},
     {"symnmf", py_symnmf, METH_VARARGS,symnmf_doc},
+    {"symnmf_stats", py_symnmf_stats, METH_VARARGS, symnmf_stats_doc},
+    {"symnmf_checkpoint", py_symnmf_checkpoint, METH_VARARGS, symnmf_checkpoint_doc},
+    {"symnmf_resume", py_symnmf_resume, METH_VARARGS, symnmf_resume_doc},
+    {"symnmf_minibatch", py_symnmf_minibatch, METH_VARARGS, symnmf_minibatch_doc},
+    {"symnmf_nystrom", py_symnmf_nystrom, METH_VARARGS, symnmf_nystrom_doc},
+    {"symnmf_sharded", py_symnmf_sharded, METH_VARARGS, symnmf_sharded_doc},
+    {"set_placement", py_set_placement, METH_VARARGS, set_placement_doc},
+    {"set_tiles", py_set_tiles, METH_VARARGS, set_tiles_doc},
+    {"assign", py_assign, METH_VARARGS, assign_doc},
+    {"silhouette", py_silhouette, METH_VARARGS, silhouette_doc},
+    {"objective", py_objective, METH_VARARGS, objective_doc},
+    {"submit_norm", py_submit_norm, METH_VARARGS, submit_norm_doc},
+    {"submit_symnmf", py_submit_symnmf, METH_VARARGS, submit_symnmf_doc},
     {NULL, NULL, 0, NULL}
 };
 
@@ -277,5 +1264,12 @@ PyMODINIT_FUNC PyInit_symnmfmodule(void) {
     if (!m) {
         return NULL;
     }
+    JobType = PyType_FromSpec(&Job_spec);
+    if (!JobType || PyModule_AddObject(m, "Job", JobType) != 0) {
+        Py_XDECREF(JobType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(JobType);
     return m;
 }
\ No newline at end of file
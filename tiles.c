@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include "mat_utils.h"
+#include "placement.h"
+#include "scheduler.h"
+#include "tiles.h"
+
+static int configured_tile = 0;
+
+typedef struct {
+    double **A, **X, **W;
+    double *degree, *inv_sqrt;
+    int n, d, tile, blocks;
+} norm_graph;
+
+typedef struct {
+    double **WH, **HHt, **HHtH, **W, **H, **Ht;
+    int n, k, tile;
+} update_graph;
+
+void tiles_configure(const int tile){
+    configured_tile = tile > 0 ? tile : 0;
+}
+
+int tiles_size(void){
+    return configured_tile;
+}
+
+/**
+ * @brief Rows [*begin, *end) of block b of size tile.
+ */
+static void block_range(const int b, const int tile, const int n, int *begin, int *end){
+    *begin = b * tile;
+    *end = *begin + tile < n ? *begin + tile : n;
+}
+
+/**
+ * @brief Similarities of block (R, C) with R <= C, mirrored into block (C, R).
+ */
+static void affinity_tile(void *arg, const int tile_index, const int worker){
+    norm_graph *g = (norm_graph *)arg;
+    int i, j, i_begin, i_end, j_begin, j_end;
+    double value;
+    (void)worker;
+
+    block_range(tile_index / g->blocks, g->tile, g->n, &i_begin, &i_end);
+    block_range(tile_index % g->blocks, g->tile, g->n, &j_begin, &j_end);
+    for (i = i_begin; i < i_end; i++) {
+        /* on a diagonal block only j > i is computed, the rest is mirrored */
+        for (j = j_begin > i ? j_begin : i + 1; j < j_end; j++) {
+            value = exp((-calc_squared_euclidean_distance(g->X[i], g->X[j], g->d))/2.0);
+            g->A[i][j] = value;
+            g->A[j][i] = value;
+        }
+        if (i >= j_begin && i < j_end) {
+            g->A[i][i] = 0.0;
+        }
+    }
+}
+
+/**
+ * @brief Row sums of block R, in the order calc_diagonal_degree_mat adds them.
+ */
+static void degree_block(void *arg, const int block, const int worker){
+    norm_graph *g = (norm_graph *)arg;
+    int i, j, begin, end;
+    double sum;
+    (void)worker;
+
+    block_range(block, g->tile, g->n, &begin, &end);
+    for (i = begin; i < end; i++) {
+        sum = 0.0;
+        for (j = 0; j < g->n; j++) {
+            sum += g->A[i][j];
+        }
+        g->degree[i] = sum;
+        g->inv_sqrt[i] = 1.0 / sqrt(sum);
+    }
+}
+
+/**
+ * @brief Block (R, C) of W as (q_i A_ij) q_j, which is what the two diagonal products of norm evaluate to.
+ */
+static void normalize_tile(void *arg, const int tile_index, const int worker){
+    norm_graph *g = (norm_graph *)arg;
+    int i, j, i_begin, i_end, j_begin, j_end;
+    (void)worker;
+
+    block_range(tile_index / g->blocks, g->tile, g->n, &i_begin, &i_end);
+    block_range(tile_index % g->blocks, g->tile, g->n, &j_begin, &j_end);
+    for (i = i_begin; i < i_end; i++) {
+        for (j = j_begin; j < j_end; j++) {
+            g->W[i][j] = (g->inv_sqrt[i] * g->A[i][j]) * g->inv_sqrt[j];
+        }
+    }
+}
+
+static void wh_tile(void *arg, const int block, const int worker){
+    update_graph *g = (update_graph *)arg;
+    int begin, end;
+    (void)worker;
+
+    block_range(block, g->tile, g->n, &begin, &end);
+    multiply_matrixes_into(g->WH + begin, g->W + begin, g->H, end - begin, g->n, g->k);
+}
+
+static void hht_tile(void *arg, const int block, const int worker){
+    update_graph *g = (update_graph *)arg;
+    int begin, end;
+    (void)worker;
+
+    block_range(block, g->tile, g->n, &begin, &end);
+    multiply_matrixes_into(g->HHt + begin, g->H + begin, g->Ht, end - begin, g->k, g->n);
+}
+
+static void hhth_tile(void *arg, const int block, const int worker){
+    update_graph *g = (update_graph *)arg;
+    int begin, end;
+    (void)worker;
+
+    block_range(block, g->tile, g->n, &begin, &end);
+    multiply_matrixes_into(g->HHtH + begin, g->HHt + begin, g->H, end - begin, g->n, g->k);
+}
+
+/**
+ * @brief Run and free a graph, charging it to PHASE_TASKS.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int run_graph(task_graph *graph, const int failed, symnmf_stats *stats){
+    double start = STATS_START(stats);
+    long steals = 0;
+    int status = failed || task_graph_run(graph, placement_threads(), &steals) != 0;
+
+    if (status == 0 && stats != NULL) {
+        stats->tasks += task_graph_size(graph);
+        stats->steals += steals;
+    }
+    STATS_STOP(stats, PHASE_TASKS, start);
+    task_graph_free(graph);
+    return status;
+}
+
+/**
+ * @brief Number of tile rows of an n-row matrix, 0 if the tile grid of tiled_norm would not fit an int.
+ */
+static int tile_blocks(const int n, const int tile){
+    int blocks = (n + tile - 1) / tile;
+    return (double)blocks * (blocks + 2) < INT_MAX ? blocks : 0;
+}
+
+int tiled_norm(double **A, double **X, double *degree, double **W, const int n, const int d, symnmf_stats *stats){
+    int R, C, id, tasks, failed = 0, status;
+    int *affinity, *degrees;
+    task_graph *graph;
+    norm_graph g;
+
+    g.A = A;
+    g.X = X;
+    g.W = W;
+    g.degree = degree;
+    g.n = n;
+    g.d = d;
+    g.tile = configured_tile > 0 ? configured_tile : n;
+    g.blocks = tile_blocks(n, g.tile);
+    if (g.blocks == 0 || (W != NULL && degree == NULL)) {
+        return 1;
+    }
+    tasks = (X != NULL ? g.blocks * (g.blocks + 1) / 2 : 0) + (degree != NULL ? g.blocks : 0)
+            + (W != NULL ? g.blocks * g.blocks : 0);
+
+    graph = task_graph_create(tasks);
+    affinity = (int *)malloc((size_t)g.blocks * g.blocks * sizeof(int));
+    degrees = (int *)malloc(g.blocks * sizeof(int));
+    g.inv_sqrt = (double *)malloc(n * sizeof(double));
+    if (graph == NULL || affinity == NULL || degrees == NULL || g.inv_sqrt == NULL) {
+        task_graph_free(graph);
+        free(affinity);
+        free(degrees);
+        free(g.inv_sqrt);
+        return 1;
+    }
+
+    for (R = 0; X != NULL && R < g.blocks; R++) {
+        for (C = R; C < g.blocks; C++) {
+            affinity[R * g.blocks + C] = task_graph_add(graph, affinity_tile, &g, R * g.blocks + C);
+        }
+    }
+    for (R = 0; degree != NULL && R < g.blocks; R++) {
+        degrees[R] = task_graph_add(graph, degree_block, &g, R);
+        for (C = 0; X != NULL && C < g.blocks; C++) {
+            failed |= task_graph_depend(graph, affinity[R < C ? R * g.blocks + C : C * g.blocks + R], degrees[R]);
+        }
+    }
+    for (R = 0; W != NULL && R < g.blocks; R++) {
+        for (C = 0; C < g.blocks; C++) {
+            id = task_graph_add(graph, normalize_tile, &g, R * g.blocks + C);
+            failed |= task_graph_depend(graph, degrees[R], id);
+            if (C != R) {
+                failed |= task_graph_depend(graph, degrees[C], id);
+            }
+        }
+    }
+    free(affinity);
+    free(degrees);
+
+    status = run_graph(graph, failed, stats);
+    free(g.inv_sqrt);
+    for (R = 0; status == 0 && W != NULL && R < n; R++) {
+        if (degree[R] == 0) {
+            status = TILES_ZERO_DEGREE;
+        }
+    }
+    return status;
+}
+
+int tiled_update_products(double **WH, double **HHt, double **HHtH, double **W, double **H, double **Ht,
+                          const int n, const int k, symnmf_stats *stats){
+    int b, blocks, hht, failed = 0;
+    task_graph *graph;
+    update_graph g;
+
+    g.WH = WH;
+    g.HHt = HHt;
+    g.HHtH = HHtH;
+    g.W = W;
+    g.H = H;
+    g.Ht = Ht;
+    g.n = n;
+    g.k = k;
+    g.tile = configured_tile > 0 ? configured_tile : n;
+    blocks = (n + g.tile - 1) / g.tile;
+
+    graph = task_graph_create(3 * blocks);
+    if (graph == NULL) {
+        return 1;
+    }
+    for (b = 0; b < blocks; b++) {
+        task_graph_add(graph, wh_tile, &g, b);
+    }
+    for (b = 0; b < blocks; b++) {
+        hht = task_graph_add(graph, hht_tile, &g, b);
+        failed |= task_graph_depend(graph, hht, task_graph_add(graph, hhth_tile, &g, b));
+    }
+    return run_graph(graph, failed, stats);
+}
@@ -0,0 +1,70 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include "stats.h"
+
+/* Status of tiled_norm when W was requested and some degree is zero. */
+#define TILES_ZERO_DEGREE 2
+
+/**
+ * @brief Run sym, ddg, norm and the products of update_H as tiled task graphs from now on.
+ *
+ * The graphs run on placement_threads() threads with task_graph_run. Every
+ * tile computes its entries exactly as the untiled code does, so results
+ * do not depend on the tile size or on which thread ran what.
+ *
+ * @param tile Rows (and columns) per tile, <= 0 to go back to the row-split loops.
+ */
+void tiles_configure(const int tile);
+
+/**
+ * @brief Tile size set by tiles_configure, 0 when tiling is off.
+ */
+int tiles_size(void);
+
+/**
+ * @brief Compute the similarity matrix and, optionally, its degrees and the normalized matrix in one graph.
+ *
+ * The affinity tiles cover the upper triangle of A and mirror each block,
+ * so A costs half the distances. The degrees of a row block are summed as
+ * soon as the tiles of that row block are done, and each normalize tile
+ * waits only for the degrees of its own row and column blocks, so the three
+ * phases overlap instead of running one after the other.
+ *
+ * A zero degree leaves no inverse square root to normalize with, so it
+ * fails with TILES_ZERO_DEGREE when W is requested; the degrees alone are
+ * still valid.
+ *
+ * @param A n x n similarity matrix; filled from X, or read if X is NULL.
+ * @param X Input data matrix, NULL if A is already computed.
+ * @param degree Output row sums of A, n values, may be NULL if W is NULL.
+ * @param W Output n x n normalized matrix, may be NULL.
+ * @param n Number of data points.
+ * @param d Dimension of each data point.
+ * @param stats Optional telemetry, may be NULL. The graph is charged to
+ *              PHASE_TASKS, along with its task and steal counts.
+ * @return 0 on success, TILES_ZERO_DEGREE if W was requested and a degree is zero, 1 on other failures.
+ */
+int tiled_norm(double **A, double **X, double *degree, double **W, const int n, const int d, symnmf_stats *stats);
+
+/**
+ * @brief Compute W H, H H^T and H H^T H of one update_H step in one graph.
+ *
+ * The W H tiles run alongside the H H^T tiles, and each H H^T H tile starts
+ * as soon as its rows of H H^T exist.
+ *
+ * @param WH Output n x k matrix.
+ * @param HHt Output n x n matrix.
+ * @param HHtH Output n x k matrix.
+ * @param W Normalized symmetric matrix.
+ * @param H Matrix H.
+ * @param Ht Transpose of H.
+ * @param n Number of data points.
+ * @param k Number of clusters.
+ * @param stats Optional telemetry, may be NULL, charged as in tiled_norm.
+ * @return 0 on success, 1 on failure.
+ */
+int tiled_update_products(double **WH, double **HHt, double **HHtH, double **W, double **H, double **Ht,
+                          const int n, const int k, symnmf_stats *stats);
+
+#endif